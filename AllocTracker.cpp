@@ -0,0 +1,182 @@
+#include "AllocTracker.h"
+
+#ifndef UTILS_NO_ALLOC_HOOKS
+
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace {
+
+std::size_t usable_size(void *p) {
+#ifdef _WIN32
+    return _msize(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+std::size_t aligned_usable_size(void *p, std::size_t alignment) {
+#ifdef _WIN32
+    return _aligned_msize(p, alignment, 0);
+#else
+    (void)alignment;
+    return malloc_usable_size(p);
+#endif
+}
+
+void *tracked_alloc(std::size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void *p = std::malloc(size)) {
+            Utils::AllocTracker::on_alloc(size, usable_size(p));
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+void *tracked_aligned_alloc(std::size_t size, std::align_val_t al) {
+    const auto alignment = static_cast<std::size_t>(al);
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+#ifdef _WIN32
+        void *p = _aligned_malloc(size, alignment);
+#else
+        void *p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+        if (p != nullptr) {
+            Utils::AllocTracker::on_alloc(size, aligned_usable_size(p, alignment));
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+void tracked_free(void *p) {
+    if (p == nullptr) {
+        return;
+    }
+    Utils::AllocTracker::on_free(usable_size(p));
+    std::free(p);
+}
+
+void tracked_aligned_free(void *p, std::align_val_t al) {
+    if (p == nullptr) {
+        return;
+    }
+    Utils::AllocTracker::on_free(aligned_usable_size(p, static_cast<std::size_t>(al)));
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+[[maybe_unused]] const bool hooks_registered = []() {
+    Utils::AllocTracker::hooks_installed.store(true);
+    return true;
+}();
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *p = tracked_alloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return tracked_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return tracked_alloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t al) {
+    if (void *p = tracked_aligned_alloc(size, al)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t al) {
+    return operator new(size, al);
+}
+
+void *operator new(std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+    return tracked_aligned_alloc(size, al);
+}
+
+void *operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+    return tracked_aligned_alloc(size, al);
+}
+
+void operator delete(void *p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    tracked_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    tracked_free(p);
+}
+
+void operator delete(void *p, std::align_val_t al) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+void operator delete[](void *p, std::align_val_t al) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t al) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t al) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+void operator delete(void *p, std::align_val_t al, const std::nothrow_t &) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+void operator delete[](void *p, std::align_val_t al, const std::nothrow_t &) noexcept {
+    tracked_aligned_free(p, al);
+}
+
+#endif
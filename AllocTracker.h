@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <fstream>
+#include <limits>
+#include <string>
+#include <sys/resource.h>
+#endif
+
+namespace Utils {
+
+// Heap accounting fed by the global operator new/delete replacements in AllocTracker.cpp.
+// Counting only happens between start() and stop(), so the hooks cost one relaxed load
+// per allocation otherwise. Building with UTILS_NO_ALLOC_HOOKS leaves the default
+// operators in place and installed() reports false.
+namespace AllocTracker {
+
+struct Stats {
+    int64_t allocations = 0;
+    int64_t bytes = 0;           // requested bytes
+    int64_t peak_live_bytes = 0; // highest live heap above the level at start()
+};
+
+inline std::atomic<bool> hooks_installed{false};
+inline std::atomic<bool> enabled{false};
+inline std::atomic<int64_t> allocations{0};
+inline std::atomic<int64_t> bytes{0};
+inline std::atomic<int64_t> live_bytes{0};
+inline std::atomic<int64_t> peak_live_bytes{0};
+
+inline bool installed() {
+    return hooks_installed.load(std::memory_order_relaxed);
+}
+
+inline void start() {
+    allocations.store(0, std::memory_order_relaxed);
+    bytes.store(0, std::memory_order_relaxed);
+    live_bytes.store(0, std::memory_order_relaxed);
+    peak_live_bytes.store(0, std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+}
+
+inline Stats stop() {
+    enabled.store(false, std::memory_order_release);
+    return {allocations.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed),
+            peak_live_bytes.load(std::memory_order_relaxed)};
+}
+
+// Called by the hooks; usable_size is what the allocator actually handed out, so live
+// bytes balance even when the matching delete isn't sized.
+inline void on_alloc(std::size_t requested, std::size_t usable_size) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(static_cast<int64_t>(requested), std::memory_order_relaxed);
+    int64_t live = live_bytes.fetch_add(static_cast<int64_t>(usable_size), std::memory_order_relaxed) + static_cast<int64_t>(usable_size);
+    int64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+inline void on_free(std::size_t usable_size) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    live_bytes.fetch_sub(static_cast<int64_t>(usable_size), std::memory_order_relaxed);
+}
+
+} // namespace AllocTracker
+
+// Peak resident set size of the process in bytes, or 0 when unknown.
+inline int64_t peak_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<int64_t>(pmc.PeakWorkingSetSize);
+    }
+    return 0;
+#elif defined(__linux__)
+    // VmHWM rather than getrusage: it honours reset_peak_rss().
+    std::ifstream ins("/proc/self/status");
+    std::string key;
+    while (ins >> key) {
+        if (key == "VmHWM:") {
+            int64_t kb = 0;
+            ins >> kb;
+            return kb * 1024;
+        }
+        ins.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+#endif
+}
+
+// Drops the peak RSS high-water mark to the current RSS so the next peak_rss_bytes()
+// covers only what runs after this call. Returns false where that isn't supported, in
+// which case the peak is process-wide.
+inline bool reset_peak_rss() {
+#ifdef __linux__
+    std::ofstream os("/proc/self/clear_refs");
+    os << "5";
+    return static_cast<bool>(os.flush());
+#else
+    return false;
+#endif
+}
+
+} // namespace Utils
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "Utils.h"
+#include <array>
+#include <cmath>
+#include <map>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace Utils {
+
+inline std::string compiler_id() {
+    std::ostringstream os;
+#if defined(__clang__)
+    os << "clang " << __clang_major__ << "." << __clang_minor__ << "." << __clang_patchlevel__;
+#elif defined(_MSC_VER)
+    os << "msvc " << _MSC_FULL_VER;
+#elif defined(__GNUC__)
+    os << "gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "." << __GNUC_PATCHLEVEL__;
+#else
+    os << "unknown";
+#endif
+#ifdef NDEBUG
+    os << " release";
+#else
+    os << " debug";
+#endif
+    return os.str();
+}
+
+inline std::string cpu_id() {
+    std::array<unsigned, 12> brand{};
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    std::array<int, 4> regs{};
+    __cpuid(regs.data(), 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000004) {
+        return "unknown";
+    }
+    for (int i = 0; i < 3; ++i) {
+        __cpuid(regs.data(), 0x80000002 + i);
+        std::copy(regs.begin(), regs.end(), brand.begin() + 4 * i);
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000004) {
+        return "unknown";
+    }
+    for (unsigned i = 0; i < 3; ++i) {
+        __get_cpuid(0x80000002 + i, &brand[4 * i], &brand[4 * i + 1], &brand[4 * i + 2], &brand[4 * i + 3]);
+    }
+#else
+    return "unknown";
+#endif
+    std::string rv(reinterpret_cast<const char *>(brand.data()), sizeof(brand));
+    rv.erase(std::find(rv.begin(), rv.end(), '\0'), rv.end());
+    for (char &c : rv) {
+        if (c == '\t') {
+            c = ' ';
+        }
+    }
+    auto first = rv.find_first_not_of(' ');
+    auto last = rv.find_last_not_of(' ');
+    return first == std::string::npos ? "unknown" : rv.substr(first, last - first + 1);
+}
+
+struct BaselineKey {
+    std::string solver, part, input, compiler, cpu;
+
+    auto operator<=>(const BaselineKey &other) const = default;
+};
+
+// Baseline timings on disk, one bench per line:
+//   solver \t part \t input \t compiler \t cpu \t t1,t2,...   (microseconds)
+// Saving merges into the existing file, replacing only the keys that were rerun.
+struct BaselineStore {
+    std::map<BaselineKey, std::vector<double>> entries;
+
+    static BaselineStore load(const std::string &path) {
+        BaselineStore rv;
+        std::ifstream ins(path);
+        std::string line;
+        while (std::getline(ins, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            std::vector<std::string> fields;
+            std::istringstream ls{line};
+            for (std::string field; std::getline(ls, field, '\t');) {
+                fields.push_back(field);
+            }
+            if (fields.size() != 6) {
+                std::cerr << "WARNING: Ignoring malformed baseline line in " << path << ": " << line << "\n";
+                continue;
+            }
+            std::vector<double> timings;
+            std::istringstream ts{fields[5]};
+            for (std::string t; std::getline(ts, t, ',');) {
+                timings.push_back(std::stod(t));
+            }
+            std::sort(timings.begin(), timings.end());
+            rv.entries[{fields[0], fields[1], fields[2], fields[3], fields[4]}] = std::move(timings);
+        }
+        return rv;
+    }
+
+    void save(const std::string &path) const {
+        std::ofstream os(path);
+        os << "# solver\tpart\tinput\tcompiler\tcpu\ttimings_us\n";
+        os << std::fixed << std::setprecision(3);
+        for (const auto &[key, timings] : entries) {
+            os << key.solver << "\t" << key.part << "\t" << key.input << "\t" << key.compiler << "\t" << key.cpu << "\t";
+            std::string sep{""};
+            for (double t : timings) {
+                os << sep << t;
+                sep = ",";
+            }
+            os << "\n";
+        }
+    }
+
+    const std::vector<double> *find(const BaselineKey &key) const {
+        auto it = entries.find(key);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+};
+
+// One-sided Mann-Whitney U test with tie correction, normal approximation.
+// Returns the p-value for "current tends to be slower than baseline".
+inline double mann_whitney_slower_p(const std::vector<double> &baseline, const std::vector<double> &current) {
+    const auto n1 = std::ssize(current), n2 = std::ssize(baseline);
+    std::vector<std::tuple<double, bool>> all;
+    all.reserve(n1 + n2);
+    for (double t : current) {
+        all.push_back({t, true});
+    }
+    for (double t : baseline) {
+        all.push_back({t, false});
+    }
+    std::sort(all.begin(), all.end());
+
+    double current_rank_sum = 0;
+    double tie_term = 0;
+    const auto n = std::ssize(all);
+    for (std::ptrdiff_t i = 0; i < n;) {
+        auto j = i;
+        while (j < n && std::get<0>(all[j]) == std::get<0>(all[i])) {
+            ++j;
+        }
+        double avg_rank = (i + 1 + j) / 2.0;
+        for (auto k = i; k < j; ++k) {
+            if (std::get<1>(all[k])) {
+                current_rank_sum += avg_rank;
+            }
+        }
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    double u = current_rank_sum - n1 * (n1 + 1) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (static_cast<double>(n) * (n - 1)));
+    if (variance <= 0) {
+        return 1.0;
+    }
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+struct RegressionOptions {
+    double threshold = 0.05; // relative slowdown of the median that counts as a regression
+    double alpha = 0.01;     // significance level for the Mann-Whitney test
+    int min_samples = 8;     // below this on either side, report but never fail
+};
+
+struct Comparison {
+    enum class Verdict { NoBaseline, TooFewSamples, Unchanged, Improved, Regressed };
+
+    Verdict verdict;
+    double baseline_p50 = 0, current_p50 = 0, change = 0, p_value = 1;
+
+    static const char *describe(Verdict v) {
+        switch (v) {
+        case Verdict::NoBaseline:
+            return "no baseline";
+        case Verdict::TooFewSamples:
+            return "too few samples";
+        case Verdict::Unchanged:
+            return "unchanged";
+        case Verdict::Improved:
+            return "improved";
+        case Verdict::Regressed:
+            return "REGRESSED";
+        }
+        return "?";
+    }
+};
+
+inline Comparison compare_to_baseline(const std::vector<double> *baseline, const BenchResult &current, const RegressionOptions &options) {
+    Comparison rv{Comparison::Verdict::NoBaseline};
+    if (baseline == nullptr || baseline->empty()) {
+        return rv;
+    }
+    rv.baseline_p50 = (*baseline)[std::ssize(*baseline) / 2];
+    rv.current_p50 = current.p50();
+    rv.change = rv.current_p50 / rv.baseline_p50 - 1;
+    if (std::ssize(*baseline) < options.min_samples || std::ssize(current.timings) < options.min_samples) {
+        rv.verdict = Comparison::Verdict::TooFewSamples;
+        return rv;
+    }
+    double p_slower = mann_whitney_slower_p(*baseline, current.timings);
+    double p_faster = mann_whitney_slower_p(current.timings, *baseline);
+    if (rv.change > options.threshold && p_slower < options.alpha) {
+        rv.verdict = Comparison::Verdict::Regressed;
+        rv.p_value = p_slower;
+    } else if (rv.change < -options.threshold && p_faster < options.alpha) {
+        rv.verdict = Comparison::Verdict::Improved;
+        rv.p_value = p_faster;
+    } else {
+        rv.verdict = Comparison::Verdict::Unchanged;
+        rv.p_value = std::min(p_slower, p_faster);
+    }
+    return rv;
+}
+
+} // namespace Utils
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define UTILS_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define UTILS_X86 1
+#endif
+
+// Marks a function as compiled for extra instruction sets so it can sit next to the
+// baseline code and be picked at runtime. MSVC lets any function use any intrinsic, so
+// there it expands to nothing.
+#if defined(UTILS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define UTILS_TARGET(features) __attribute__((target(features)))
+#else
+#define UTILS_TARGET(features)
+#endif
+
+namespace Utils {
+
+// What the CPU we're running on (and its OS, for the wide register state) supports.
+struct CpuFeatures {
+    bool ssse3 = false;
+    bool avx2 = false;
+
+    static const CpuFeatures &get() {
+        static const CpuFeatures rv = detect();
+        return rv;
+    }
+
+    static CpuFeatures detect() {
+        CpuFeatures rv;
+#ifdef UTILS_X86
+        auto cpuid = [](unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+            int r[4];
+            __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; ++i) {
+                regs[i] = static_cast<unsigned>(r[i]);
+            }
+#else
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        };
+        unsigned regs[4]{};
+        cpuid(0, 0, regs);
+        const unsigned max_leaf = regs[0];
+        if (max_leaf < 1) {
+            return rv;
+        }
+        cpuid(1, 0, regs);
+        rv.ssse3 = regs[2] & (1u << 9);
+        const bool osxsave = regs[2] & (1u << 27);
+        uint64_t xcr0 = 0;
+        if (osxsave) {
+#ifdef _MSC_VER
+            xcr0 = _xgetbv(0);
+#else
+            unsigned lo, hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            xcr0 = (uint64_t{hi} << 32) | lo;
+#endif
+        }
+        const bool ymm_state = (xcr0 & 0x6) == 0x6;
+        if (max_leaf >= 7) {
+            cpuid(7, 0, regs);
+            rv.avx2 = ymm_state && (regs[1] & (1u << 5));
+        }
+#endif
+        return rv;
+    }
+};
+
+} // namespace Utils
@@ -1,5 +1,378 @@
-#include "day25/Day25A.h"
+#include "Baseline.h"
+#include "Registry.h"
+#include "Scaling.h"
 
-int main() {
-    Day25A::main();
-}
\ No newline at end of file
+namespace {
+
+struct Options {
+    std::vector<std::string> selectors;
+    bool list = false;
+    bool run_tests = true;
+    bool run_benches = true;
+    int jobs = Utils::ThreadPool::default_thread_count();
+    Utils::BenchOptions bench;
+    bool iterations_given = false;
+    std::string json_path, csv_path;
+    std::string save_baseline_path, compare_path;
+    std::string trace_path;
+    bool scaling = false;
+    std::vector<int64_t> sizes;
+    uint64_t seed = 1;
+    int64_t generate_n = -1;
+    Utils::RegressionOptions regression;
+};
+
+void usage() {
+    std::cout << "usage: adventofcode2021vs4 [options] [selector...]\n"
+                 "  selector           day id or base dir, globs allowed (Day16A, day22, Day2*); default: all\n"
+                 "  --list             list registered days and exit\n"
+                 "  --no-test          skip the correctness tests\n"
+                 "  --no-bench         skip the benchmarks\n"
+                 "  --jobs N           run up to N test cases in parallel (default: one per hardware thread)\n"
+                 "  --iterations N     iterations per bench (default "
+              << Utils::BenchOptions{}.iterations << ")\n"
+              << "  --budget SECONDS   stop a bench early after this much wall time (default 10)\n"
+                 "  --adaptive         pin to a CPU, warm up, then sample until the median's 95% CI is narrow enough\n"
+                 "  --target-ci PCT    CI half-width to stop at in adaptive mode (default "
+              << Utils::BenchOptions{}.target_ci * 100 << ")\n"
+              << "  --pin CPU          CPU to pin to in adaptive mode (default: the current one)\n"
+                 "  --counters         also record hardware performance counters per iteration (Linux)\n"
+                 "  --allocs           also count heap allocations per iteration and report peak RSS\n"
+                 "  --scaling          instead of benching, sweep generated inputs of growing size; report time and memory against n\n"
+                 "  --sizes N,N,...    sizes to sweep (default: per day)\n"
+                 "  --seed S           generator seed (default 1)\n"
+                 "  --generate N       print a generated input of size N for the one selected day and exit\n"
+                 "  --json PATH        write bench results as JSON\n"
+                 "  --csv PATH         write bench results as CSV\n"
+                 "  --trace PATH       record trace scopes and write them as Chrome trace JSON (open in Perfetto)\n"
+                 "  --save-baseline PATH  merge bench timings into a baseline file\n"
+                 "  --compare PATH     compare against a baseline file; exit 1 on a significant regression\n"
+                 "  --threshold PCT    median slowdown that counts as a regression (default "
+              << Utils::RegressionOptions{}.threshold * 100 << ")\n"
+              << "  --alpha P          Mann-Whitney significance level (default " << Utils::RegressionOptions{}.alpha << ")\n";
+}
+
+Options parse_args(int argc, char **argv) {
+    Options options;
+    options.bench.budget_seconds = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: Missing value for " << arg << "\n";
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--help" || arg == "-h") {
+            usage();
+            exit(0);
+        } else if (arg == "--list") {
+            options.list = true;
+        } else if (arg == "--no-test") {
+            options.run_tests = false;
+        } else if (arg == "--no-bench") {
+            options.run_benches = false;
+        } else if (arg == "--jobs") {
+            options.jobs = std::max(1, std::stoi(value()));
+        } else if (arg == "--iterations") {
+            options.bench.iterations = std::max(1, std::stoi(value()));
+            options.iterations_given = true;
+        } else if (arg == "--budget") {
+            options.bench.budget_seconds = std::stod(value());
+        } else if (arg == "--adaptive") {
+            options.bench.adaptive = true;
+        } else if (arg == "--target-ci") {
+            options.bench.target_ci = std::stod(value()) / 100;
+        } else if (arg == "--pin") {
+            options.bench.pin_cpu = std::stoi(value());
+        } else if (arg == "--counters") {
+            options.bench.perf_counters = true;
+        } else if (arg == "--allocs") {
+            options.bench.track_allocations = true;
+        } else if (arg == "--scaling") {
+            options.scaling = true;
+            options.run_benches = false;
+        } else if (arg == "--sizes") {
+            std::istringstream iss{value()};
+            for (std::string size; std::getline(iss, size, ',');) {
+                options.sizes.push_back(std::stoll(size));
+            }
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value());
+        } else if (arg == "--generate") {
+            options.generate_n = std::stoll(value());
+        } else if (arg == "--json") {
+            options.json_path = value();
+        } else if (arg == "--csv") {
+            options.csv_path = value();
+        } else if (arg == "--trace") {
+            options.trace_path = value();
+        } else if (arg == "--save-baseline") {
+            options.save_baseline_path = value();
+        } else if (arg == "--compare") {
+            options.compare_path = value();
+        } else if (arg == "--threshold") {
+            options.regression.threshold = std::stod(value()) / 100;
+        } else if (arg == "--alpha") {
+            options.regression.alpha = std::stod(value());
+        } else if (arg.starts_with("--")) {
+            std::cerr << "ERROR: Unknown option: " << arg << "\n";
+            usage();
+            exit(2);
+        } else {
+            options.selectors.push_back(arg);
+        }
+    }
+    if (options.bench.adaptive && !options.iterations_given) {
+        options.bench.iterations = 100000;
+    }
+    return options;
+}
+
+struct BenchRecord {
+    std::string id;
+    Utils::BenchResult result;
+};
+
+std::string json_escape(const std::string &s) {
+    std::string rv;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            rv.push_back('\\');
+        }
+        rv.push_back(c);
+    }
+    return rv;
+}
+
+void write_json(const std::string &path, const std::vector<BenchRecord> &records, const std::vector<Utils::ScalingResult> &scalings) {
+    std::ofstream os(path);
+    os << std::fixed << std::setprecision(3);
+    os << "{\n  \"unit\": \"us\",\n  \"benches\": [";
+    std::string sep{"\n"};
+    for (const auto &[id, r] : records) {
+        os << sep << "    {\"solver\": \"" << json_escape(id) << "\", \"day\": \"" << json_escape(r.base_dir)
+           << "\", \"part\": \"" << json_escape(r.display_prefix) << "\", \"input\": \"" << json_escape(r.name)
+           << "\", \"iterations\": " << std::ssize(r.timings)
+           << ", \"pMin\": " << r.p_min() << ", \"p5\": " << r.p5() << ", \"p50\": " << r.p50()
+           << ", \"p95\": " << r.p95() << ", \"pMax\": " << r.p_max();
+        if (!r.metrics.empty()) {
+            os << ", \"metrics\": {";
+            std::string metric_sep{""};
+            for (const auto &[metric_name, values] : r.metrics) {
+                os << metric_sep << "\"" << json_escape(metric_name) << "\": {\"pMin\": " << Utils::p_min_of(values)
+                   << ", \"p5\": " << Utils::p5_of(values) << ", \"p50\": " << Utils::p50_of(values)
+                   << ", \"p95\": " << Utils::p95_of(values) << ", \"pMax\": " << Utils::p_max_of(values) << "}";
+                metric_sep = ", ";
+            }
+            os << "}";
+            if (r.counters_calling_thread_only) {
+                os << ", \"countersCallingThreadOnly\": true";
+            }
+        }
+        if (r.warmup_iterations > 0 || r.converged) {
+            os << ", \"warmup\": " << r.warmup_iterations << ", \"converged\": " << (r.converged ? "true" : "false")
+               << ", \"outliers\": " << std::ssize(r.outliers);
+        }
+        if (r.peak_rss_bytes > 0) {
+            os << ", \"peakRssBytes\": " << r.peak_rss_bytes;
+        }
+        os << ", \"inputBytes\": " << r.input_bytes;
+        if (r.items > 0) {
+            os << ", \"items\": " << r.items << ", \"itemUnit\": \"" << json_escape(r.item_unit) << "\"";
+        }
+        os << "}";
+        sep = ",\n";
+    }
+    os << "\n  ]";
+    if (!scalings.empty()) {
+        os << ",\n  \"scaling\": [";
+        sep = "\n";
+        for (const auto &s : scalings) {
+            os << sep << "    {\"solver\": \"" << json_escape(s.id) << "\", \"part\": \"" << json_escape(s.display_prefix)
+               << "\", \"unit\": \"" << json_escape(s.unit) << "\", \"points\": [";
+            std::string point_sep{""};
+            for (const auto &point : s.points) {
+                os << point_sep << "{\"n\": " << point.n << ", \"inputBytes\": " << point.input_bytes << ", \"p50\": " << point.p50()
+                   << ", \"peakHeapBytes\": " << point.peak_heap_bytes << ", \"peakRssBytes\": " << point.peak_rss_bytes << "}";
+                point_sep = ", ";
+            }
+            os << "]}";
+            sep = ",\n";
+        }
+        os << "\n  ]";
+    }
+    os << "\n}\n";
+}
+
+void write_csv(const std::string &path, const std::vector<BenchRecord> &records) {
+    std::ofstream os(path);
+    os << std::fixed << std::setprecision(3);
+    os << "solver,day,part,input,iterations,pMin_us,p5_us,p50_us,p95_us,pMax_us\n";
+    for (const auto &[id, r] : records) {
+        os << id << "," << r.base_dir << "," << r.display_prefix << "," << r.name << "," << std::ssize(r.timings) << ","
+           << r.p_min() << "," << r.p5() << "," << r.p50() << "," << r.p95() << "," << r.p_max() << "\n";
+    }
+}
+
+Utils::BaselineKey baseline_key(const BenchRecord &record) {
+    static const std::string compiler = Utils::compiler_id();
+    static const std::string cpu = Utils::cpu_id();
+    return {record.id, record.result.display_prefix, record.result.name, compiler, cpu};
+}
+
+bool compare_baseline(const std::string &path, const std::vector<BenchRecord> &records, const Utils::RegressionOptions &options) {
+    const auto baseline = Utils::BaselineStore::load(path);
+    std::cout << "\n>=====  BASELINE COMPARISON  =====<\n";
+    std::cout << "  compiler: " << Utils::compiler_id() << "\n";
+    std::cout << "  cpu     : " << Utils::cpu_id() << "\n\n";
+    std::cout << std::fixed;
+    bool any_regressed = false;
+    for (const auto &record : records) {
+        const auto key = baseline_key(record);
+        const auto cmp = Utils::compare_to_baseline(baseline.find(key), record.result, options);
+        std::cout << "  " << std::left << std::setw(28) << (key.solver + ":" + key.part + ":" + key.input) << std::right;
+        if (cmp.verdict == Utils::Comparison::Verdict::NoBaseline) {
+            std::cout << "  " << Utils::Comparison::describe(cmp.verdict) << "\n";
+            continue;
+        }
+        std::cout << std::setprecision(1) << "  p50 " << std::setw(10) << cmp.baseline_p50 << " -> " << std::setw(10) << cmp.current_p50 << " us"
+                  << "  " << std::showpos << std::setw(6) << cmp.change * 100 << std::noshowpos << "%"
+                  << std::setprecision(4) << "  p=" << cmp.p_value
+                  << "  " << Utils::Comparison::describe(cmp.verdict) << "\n";
+        if (cmp.verdict == Utils::Comparison::Verdict::Regressed) {
+            any_regressed = true;
+        }
+    }
+    std::cout << std::setprecision(1) << "\n";
+    if (any_regressed) {
+        std::cout << "PERFORMANCE REGRESSION!\n";
+    }
+    return !any_regressed;
+}
+
+void save_baseline(const std::string &path, const std::vector<BenchRecord> &records) {
+    auto baseline = Utils::BaselineStore::load(path);
+    for (const auto &record : records) {
+        baseline.entries[baseline_key(record)] = record.result.timings;
+    }
+    baseline.save(path);
+    std::cout << "Saved " << std::ssize(records) << " bench results to baseline " << path << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const Options options = parse_args(argc, argv);
+
+    std::vector<const Utils::DayEntry *> days;
+    for (const auto &day : Utils::registry()) {
+        if (Utils::selected(day, options.selectors)) {
+            days.push_back(&day);
+        }
+    }
+    std::sort(days.begin(), days.end(), [](const auto *a, const auto *b) { return a->id < b->id; });
+
+    if (options.list) {
+        for (const auto *day : days) {
+            std::cout << day->id << "  (" << day->base_dir << ", " << std::ssize(day->tests) << " tests, "
+                      << std::ssize(day->benches) << " benches";
+            if (day->generator) {
+                std::cout << ", generator by " << day->generator_unit;
+            }
+            std::cout << ")\n";
+        }
+        return 0;
+    }
+    if (days.empty()) {
+        std::cerr << "ERROR: No registered day matches the given selectors\n";
+        return 2;
+    }
+
+    if (options.generate_n >= 0) {
+        if (days.size() != 1 || !days[0]->generator) {
+            std::cerr << "ERROR: --generate needs exactly one selected day that has a generator\n";
+            return 2;
+        }
+        std::mt19937_64 rng{options.seed};
+        std::cout << days[0]->generator(options.generate_n, rng);
+        return 0;
+    }
+    if (!options.trace_path.empty()) {
+        Utils::Trace::enable();
+    }
+
+    bool all_ok = true;
+    std::vector<const Utils::DayEntry *> passing;
+    if (options.run_tests) {
+        // One tester for every selected day so cases from different days share the pool;
+        // each day remembers which slice of the results is its own.
+        Utils::Tester tester;
+        tester.jobs = options.jobs;
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        for (const auto *day : days) {
+            tester.base_dir = day->base_dir;
+            const std::size_t begin = tester.pending.size();
+            for (const auto &c : day->tests) {
+                tester.test(day->id + ":" + c.display_prefix, c.name, c.expected, c.solver);
+            }
+            ranges.push_back({begin, tester.pending.size()});
+        }
+        if (!tester.summarize()) {
+            all_ok = false;
+        }
+        for (std::size_t d = 0; d < days.size(); ++d) {
+            const auto &[begin, end] = ranges[d];
+            if (std::all_of(tester.results.begin() + begin, tester.results.begin() + end,
+                            [](const auto &result) { return std::get<1>(result); })) {
+                passing.push_back(days[d]);
+            } else {
+                std::cout << "Skipping benches of " << days[d]->id << ".\n";
+            }
+        }
+    } else {
+        passing = days;
+    }
+
+    std::vector<BenchRecord> records;
+    if (options.run_benches) {
+        for (const auto *day : passing) {
+            for (const auto &c : day->benches) {
+                records.push_back({day->id, Utils::bench(day->base_dir, c.display_prefix, c.name, c.expected, options.bench, c.solver, c.item_count)});
+            }
+        }
+    }
+
+    std::vector<Utils::ScalingResult> scalings;
+    if (options.scaling) {
+        const int iterations = options.iterations_given ? options.bench.iterations : 3;
+        for (const auto *day : passing) {
+            for (const auto &c : day->scalings) {
+                const auto &sizes = options.sizes.empty() ? c.sizes : options.sizes;
+                scalings.push_back(Utils::scaling_sweep(*day, c, sizes, iterations, options.bench.budget_seconds, options.seed));
+            }
+        }
+    }
+
+    if (!options.trace_path.empty()) {
+        Utils::Trace::enable(false);
+        Utils::Trace::write_chrome_json(options.trace_path);
+    }
+    if (!options.json_path.empty()) {
+        write_json(options.json_path, records, scalings);
+    }
+    if (!options.csv_path.empty()) {
+        write_csv(options.csv_path, records);
+    }
+    if (!options.compare_path.empty() && !compare_baseline(options.compare_path, records, options.regression)) {
+        all_ok = false;
+    }
+    if (!options.save_baseline_path.empty()) {
+        save_baseline(options.save_baseline_path, records);
+    }
+    if (!all_ok) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Utils {
+
+// Hardware counters for the calling thread around a single solver call. Each counter is opened as
+// its own event (not a group) so a PMU that can't schedule all of them at once still
+// yields the ones it can, scaled for multiplexing. Anywhere perf_event_open isn't
+// available, open() returns an object with every counter missing and a reason.
+struct PerfCounters {
+    enum Counter { Cycles, Instructions, L1DMisses, LLCMisses, BranchMisses, DTLBMisses, COUNT };
+    static constexpr std::array<const char *, COUNT> names{"cycles", "instructions", "L1d-miss", "LLC-miss", "br-miss", "dTLB-miss"};
+
+    using Sample = std::array<std::optional<double>, COUNT>;
+
+    std::array<int, COUNT> fds;
+    std::string unavailable_reason;
+
+    PerfCounters() { fds.fill(-1); }
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    PerfCounters(PerfCounters &&other) noexcept : fds(other.fds), unavailable_reason(std::move(other.unavailable_reason)) {
+        other.fds.fill(-1);
+    }
+    PerfCounters &operator=(PerfCounters &&other) noexcept {
+        std::swap(fds, other.fds);
+        std::swap(unavailable_reason, other.unavailable_reason);
+        return *this;
+    }
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static PerfCounters open() {
+        PerfCounters rv;
+#ifdef __linux__
+        auto cache_event = [](uint64_t cache, uint64_t op, uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        };
+        const std::array<std::tuple<uint32_t, uint64_t>, COUNT> events{{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        }};
+        for (int i = 0; i < COUNT; ++i) {
+            const auto &[type, config] = events[i];
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1; // threads spawned during the call count, already running ones (pool workers) don't
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            rv.fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (rv.fds[i] < 0 && rv.unavailable_reason.empty()) {
+                rv.unavailable_reason = std::string{names[i]} + ": " + std::strerror(errno);
+            }
+        }
+#else
+        rv.unavailable_reason = "perf_event_open is Linux-only";
+#endif
+        return rv;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    Sample stop() {
+        Sample rv{};
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < COUNT; ++i) {
+            uint64_t values[3]{}; // value, time_enabled, time_running
+            if (fds[i] < 0 || ::read(fds[i], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+                continue;
+            }
+            rv[i] = static_cast<double>(values[0]) * values[1] / values[2];
+        }
+#endif
+        return rv;
+    }
+};
+
+} // namespace Utils
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Utils.h"
+#include <cctype>
+#include <random>
+
+namespace Utils {
+
+struct SolverCase {
+    std::string display_prefix, name, expected;
+    ErasedSolver solver;
+    ItemCount item_count; // benches only
+};
+
+// Produces a valid puzzle input of size n (in the day's own unit: packets, scanners,
+// cuboids, grid side...), deterministic for a given rng state.
+using Generator = std::function<std::string(int64_t n, std::mt19937_64 &rng)>;
+
+struct ScalingCase {
+    std::string display_prefix;
+    std::vector<int64_t> sizes; // default sweep, overridable from the command line
+    ErasedSolver solver;
+};
+
+// Everything one day/part knows about itself: where its inputs live, which cases check
+// it and which cases are worth benchmarking.
+struct DayEntry {
+    std::string id;       // e.g. "Day16A"
+    std::string base_dir; // e.g. "day16"
+    std::vector<SolverCase> tests;
+    std::vector<SolverCase> benches;
+    std::string generator_unit;
+    Generator generator;
+    std::vector<ScalingCase> scalings;
+
+    DayEntry(std::string id, std::string base_dir) : id(std::move(id)), base_dir(std::move(base_dir)) {}
+
+    void test(const std::string &display_prefix, const std::string &name, const std::string &expected, auto solver) {
+        tests.push_back({display_prefix, name, expected, erase_solver(solver), {}});
+    }
+
+    void bench(const std::string &display_prefix, const std::string &name, const std::string &expected, auto solver,
+               ItemCount item_count = {}) {
+        benches.push_back({display_prefix, name, expected, erase_solver(solver), std::move(item_count)});
+    }
+
+    void generate(const std::string &unit, Generator fn) {
+        generator_unit = unit;
+        generator = std::move(fn);
+    }
+
+    void scaling(const std::string &display_prefix, std::vector<int64_t> sizes, auto solver) {
+        scalings.push_back({display_prefix, std::move(sizes), erase_solver(solver)});
+    }
+};
+
+inline std::vector<DayEntry> &registry() {
+    static std::vector<DayEntry> days;
+    return days;
+}
+
+// Declared at namespace scope in each day's translation unit:
+//   const Utils::Registration registration{"Day16A", "day16", [](Utils::DayEntry &day) { ... }};
+struct Registration {
+    Registration(const std::string &id, const std::string &base_dir, auto fn) {
+        DayEntry entry{id, base_dir};
+        fn(entry);
+        registry().push_back(std::move(entry));
+    }
+};
+
+// Case-insensitive glob supporting '*' and '?'.
+inline bool glob_match(std::string_view pattern, std::string_view text) {
+    auto lower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+    std::size_t p = 0, t = 0;
+    std::size_t star = std::string_view::npos, star_t = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || lower(pattern[p]) == lower(text[t]))) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_t = t;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++star_t;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+inline bool selected(const DayEntry &day, const std::vector<std::string> &selectors) {
+    if (selectors.empty()) {
+        return true;
+    }
+    return std::any_of(selectors.begin(), selectors.end(), [&](const std::string &selector) {
+        return glob_match(selector, day.id) || glob_match(selector, day.base_dir);
+    });
+}
+
+} // namespace Utils
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Registry.h"
+#include <cmath>
+
+namespace Utils {
+
+struct ScalingPoint {
+    int64_t n = 0;
+    int64_t input_bytes = 0;
+    std::vector<double> timings; // sorted, microseconds
+    int64_t peak_heap_bytes = 0; // live heap high-water mark of the first run, 0 when not tracked
+    int64_t peak_rss_bytes = 0;
+
+    double p50() const {
+        return p50_of(timings);
+    }
+};
+
+struct ScalingResult {
+    std::string id, display_prefix, unit;
+    std::vector<ScalingPoint> points;
+};
+
+// Runs one scaling case over growing generated inputs and prints time and memory
+// against n, with the log-log slope between neighbouring sizes (1 = linear, 2 =
+// quadratic...). The sweep stops after the first size whose run exceeds budget_seconds,
+// so the default size lists can reach further than the slow solvers will go.
+inline ScalingResult scaling_sweep(const DayEntry &day, const ScalingCase &c, const std::vector<int64_t> &sizes,
+                                   int iterations, double budget_seconds, uint64_t seed) {
+    using clock = std::chrono::high_resolution_clock;
+
+    ScalingResult rv{day.id, c.display_prefix, day.generator_unit, {}};
+    std::cout << ">=====  SCALING  =====<\n";
+    std::cout << "  " << day.id << ":" << c.display_prefix << " against n = " << day.generator_unit << " (seed " << seed << ")\n\n";
+    std::cout << std::setw(12) << "n" << std::setw(12) << "input KB" << std::setw(14) << "p50 ms" << std::setw(8) << "slope"
+              << std::setw(14) << "peak heap MB" << std::setw(14) << "peak RSS MB" << "\n";
+    std::cout << std::fixed;
+
+    for (int64_t n : sizes) {
+        std::mt19937_64 rng{seed};
+        const std::string input = day.generator(n, rng);
+        const InputView view{input};
+
+        ScalingPoint point;
+        point.n = n;
+        point.input_bytes = std::ssize(input);
+        const bool rss_resettable = reset_peak_rss();
+        double elapsed_seconds = 0;
+        for (int i = 0; i < iterations && (i == 0 || elapsed_seconds < budget_seconds); ++i) {
+            const bool track = i == 0 && AllocTracker::installed();
+            std::ostringstream oss;
+            if (track) {
+                AllocTracker::start();
+            }
+            // progress lines from the solver would drown the table
+            std::string discarded;
+            CoutCaptureBuf capture_buf{std::cout.rdbuf()};
+            std::cout.rdbuf(&capture_buf);
+            CoutCaptureBuf::capture = &discarded;
+            auto start = clock::now();
+            c.solver(view, oss);
+            auto end = clock::now();
+            CoutCaptureBuf::capture = nullptr;
+            std::cout.rdbuf(capture_buf.original);
+            if (track) {
+                point.peak_heap_bytes = AllocTracker::stop().peak_live_bytes;
+            }
+            const double us = std::chrono::duration<double, std::micro>(end - start).count();
+            point.timings.push_back(us);
+            elapsed_seconds += us / 1e6;
+        }
+        std::sort(point.timings.begin(), point.timings.end());
+        point.peak_rss_bytes = rss_resettable ? peak_rss_bytes() : 0;
+
+        std::cout << std::setw(12) << n << std::setprecision(1) << std::setw(12) << point.input_bytes / 1024.0
+                  << std::setprecision(3) << std::setw(14) << point.p50() / 1000;
+        if (!rv.points.empty() && rv.points.back().n != n && rv.points.back().p50() > 0) {
+            const auto &prev = rv.points.back();
+            const double slope = std::log(point.p50() / prev.p50()) / std::log(static_cast<double>(n) / prev.n);
+            std::cout << std::setprecision(2) << std::setw(8) << slope;
+        } else {
+            std::cout << std::setw(8) << "-";
+        }
+        std::cout << std::setprecision(1) << std::setw(14) << point.peak_heap_bytes / (1024.0 * 1024.0) << std::setw(14);
+        if (point.peak_rss_bytes > 0) {
+            std::cout << point.peak_rss_bytes / (1024.0 * 1024.0) << "\n";
+        } else {
+            std::cout << "-" << "\n";
+        }
+        rv.points.push_back(std::move(point));
+
+        if (rv.points.back().timings.front() / 1e6 > budget_seconds) {
+            std::cout << "  (stopping: one run took longer than the " << std::setprecision(0) << budget_seconds << " s budget)\n";
+            break;
+        }
+    }
+    std::cout << std::setprecision(1) << "\n";
+    return rv;
+}
+
+} // namespace Utils
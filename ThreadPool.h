@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Utils {
+
+// Fixed-size pool of worker threads fed from one FIFO queue. The destructor finishes
+// everything already submitted before joining.
+struct ThreadPool {
+    static int default_thread_count() {
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    explicit ThreadPool(int thread_count = default_thread_count()) {
+        thread_count = std::max(1, thread_count);
+        workers.reserve(thread_count);
+        for (int i = 0; i < thread_count; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Pool for solvers that split their own work. It is separate from the pool running
+    // test cases, so a case waiting on its tasks never holds a worker those tasks need.
+    static ThreadPool &shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    int size() const {
+        return static_cast<int>(workers.size());
+    }
+
+    // Tasks submitted since the pool was created.
+    int64_t submitted_count() const {
+        return submitted.load(std::memory_order_relaxed);
+    }
+
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<std::invoke_result_t<Fn &>> {
+        using Result = std::invoke_result_t<Fn &>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        auto future = task->get_future();
+        {
+            std::lock_guard lock{mutex};
+            queue.push_back([task]() { (*task)(); });
+        }
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        cv.notify_one();
+        return future;
+    }
+
+    // Runs fn(i) for every i in [begin, end), split into about four chunks per worker,
+    // and waits for all of them.
+    template <typename Fn>
+    void parallel_for(int64_t begin, int64_t end, Fn fn) {
+        const int64_t n = end - begin;
+        if (n <= 0) {
+            return;
+        }
+        const int64_t chunks = std::min<int64_t>(n, 4 * int64_t{size()});
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunks);
+        for (int64_t c = 0; c < chunks; ++c) {
+            int64_t lo = begin + n * c / chunks, hi = begin + n * (c + 1) / chunks;
+            futures.push_back(submit([lo, hi, &fn]() {
+                for (int64_t i = lo; i < hi; ++i) {
+                    fn(i);
+                }
+            }));
+        }
+        for (auto &f : futures) {
+            f.get();
+        }
+    }
+
+  private:
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::atomic<int64_t> submitted{0};
+};
+
+} // namespace Utils
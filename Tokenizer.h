@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_TOKENIZER_SSE2
+#endif
+
+namespace Utils {
+
+// Byte classes used by Tokenizer. Whitespace is anything at or below ' ', which covers
+// '\n', '\r' and '\t' and is all AoC inputs ever contain.
+inline bool is_digit_byte(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline bool is_space_byte(char c) {
+    return static_cast<unsigned char>(c) <= ' ';
+}
+
+// Index of the first byte in [pos, s.size()) of the wanted class, or s.size(). Whole
+// vectors are classified at once (32 bytes with AVX2, 16 with SSE2) and the first hit
+// is taken from the match mask; the tail is scanned one byte at a time.
+enum class ByteClass { Digit, Space, NonSpace };
+
+template <ByteClass Class>
+inline std::size_t find_byte_class(std::string_view s, std::size_t pos) {
+    const char *p = s.data();
+    const std::size_t n = s.size();
+#if defined(__AVX2__)
+    for (; pos + 32 <= n; pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + pos));
+        __m256i hit;
+        if constexpr (Class == ByteClass::Digit) {
+            // c - '0' <= 9 unsigned  <=>  min(c - '0', 9) == c - '0'
+            const __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+            hit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+        } else {
+            // c <= ' ' unsigned  <=>  max(c, ' ') == ' '
+            hit = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(' ')), _mm256_set1_epi8(' '));
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if constexpr (Class == ByteClass::NonSpace) {
+            mask = ~mask;
+        }
+        if (mask != 0) {
+            return pos + std::countr_zero(mask);
+        }
+    }
+#elif defined(UTILS_TOKENIZER_SSE2)
+    for (; pos + 16 <= n; pos += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + pos));
+        __m128i hit;
+        if constexpr (Class == ByteClass::Digit) {
+            const __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+            hit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+        } else {
+            hit = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(' ')), _mm_set1_epi8(' '));
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if constexpr (Class == ByteClass::NonSpace) {
+            mask = ~mask & 0xffff;
+        }
+        if (mask != 0) {
+            return pos + std::countr_zero(mask);
+        }
+    }
+#endif
+    for (; pos < n; ++pos) {
+        const bool hit = Class == ByteClass::Digit   ? is_digit_byte(p[pos])
+                         : Class == ByteClass::Space ? is_space_byte(p[pos])
+                                                     : !is_space_byte(p[pos]);
+        if (hit) {
+            return pos;
+        }
+    }
+    return n;
+}
+
+// Pulls integers, words and lines out of a buffer without copying or allocating.
+//   next_int()  skips to the next digit and reads the run; a '-' right before the
+//               first digit makes it negative, so "x=-5..12" yields -5 then 12
+//   next_word() next run of non-whitespace bytes
+//   next_line() up to the next '\n' (dropping a '\r'), possibly empty
+struct Tokenizer {
+    std::string_view data;
+    std::size_t pos = 0;
+
+    bool done() const {
+        return pos >= data.size();
+    }
+
+    std::optional<int64_t> next_int() {
+        const std::size_t begin = find_byte_class<ByteClass::Digit>(data, pos);
+        if (begin == data.size()) {
+            pos = begin;
+            return std::nullopt;
+        }
+        const bool negative = begin > pos && data[begin - 1] == '-';
+        int64_t value = 0;
+        std::size_t i = begin;
+        for (; i < data.size() && is_digit_byte(data[i]); ++i) {
+            value = value * 10 + (data[i] - '0');
+        }
+        pos = i;
+        return negative ? -value : value;
+    }
+
+    int64_t expect_int() {
+        auto value = next_int();
+        if (!value.has_value()) {
+            std::cerr << "ERROR: Expected an integer at offset " << pos << "\n";
+            abort();
+        }
+        return *value;
+    }
+
+    std::optional<std::string_view> next_word() {
+        const std::size_t begin = find_byte_class<ByteClass::NonSpace>(data, pos);
+        if (begin == data.size()) {
+            pos = begin;
+            return std::nullopt;
+        }
+        pos = find_byte_class<ByteClass::Space>(data, begin);
+        return data.substr(begin, pos - begin);
+    }
+
+    std::string_view expect_word() {
+        auto word = next_word();
+        if (!word.has_value()) {
+            std::cerr << "ERROR: Expected a word at offset " << pos << "\n";
+            abort();
+        }
+        return *word;
+    }
+
+    std::optional<std::string_view> next_line() {
+        if (done()) {
+            return std::nullopt;
+        }
+        const void *eol = std::memchr(data.data() + pos, '\n', data.size() - pos);
+        const std::size_t end = eol != nullptr ? static_cast<const char *>(eol) - data.data() : data.size();
+        std::string_view line = data.substr(pos, end - pos);
+        pos = std::min(end + 1, data.size());
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+};
+
+} // namespace Utils
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Utils {
+
+// Scoped wall-time tracing exported as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev). Each thread records complete events into its own fixed-size ring
+// buffer, so recording takes no lock; once a ring is full the oldest events are
+// overwritten. While tracing is off a scope costs one relaxed load. Building with
+// UTILS_NO_TRACE compiles UTILS_TRACE_SCOPE away entirely.
+//
+//   UTILS_TRACE_SCOPE("parse");
+//   UTILS_TRACE_SCOPE("Scanner::match", "scanner", i, "reference", j);
+namespace Trace {
+
+struct Event {
+    const char *name;
+    std::array<const char *, 2> arg_names;
+    std::array<int64_t, 2> args;
+    int64_t begin_ns, end_ns;
+};
+
+const std::size_t RING_CAPACITY = 1 << 16;
+
+struct ThreadRing {
+    int tid;
+    std::vector<Event> events = std::vector<Event>(RING_CAPACITY);
+    std::atomic<uint64_t> written{0};
+
+    void push(const Event &event) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        events[n % RING_CAPACITY] = event;
+        written.store(n + 1, std::memory_order_release);
+    }
+};
+
+inline std::atomic<bool> enabled_flag{false};
+inline std::mutex rings_mutex;
+inline std::vector<std::shared_ptr<ThreadRing>> rings; // kept past thread exit for export
+inline std::deque<std::string> interned;
+
+inline bool enabled() {
+    return enabled_flag.load(std::memory_order_relaxed);
+}
+
+inline void enable(bool on = true) {
+    enabled_flag.store(on, std::memory_order_release);
+}
+
+inline int64_t now_ns() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+inline ThreadRing &this_thread_ring() {
+    thread_local std::shared_ptr<ThreadRing> ring = []() {
+        std::lock_guard lock{rings_mutex};
+        auto rv = std::make_shared<ThreadRing>();
+        rv->tid = static_cast<int>(rings.size()) + 1;
+        rings.push_back(rv);
+        return rv;
+    }();
+    return *ring;
+}
+
+// Event names must outlive the trace; this keeps a copy of a runtime string for that.
+inline const char *intern(const std::string &s) {
+    std::lock_guard lock{rings_mutex};
+    return interned.emplace_back(s).c_str();
+}
+
+struct Scope {
+    Event event;
+
+    explicit Scope(const char *name, const char *arg0_name = nullptr, int64_t arg0 = 0,
+                   const char *arg1_name = nullptr, int64_t arg1 = 0)
+        : event{name, {arg0_name, arg1_name}, {arg0, arg1}, -1, 0} {
+        if (enabled()) {
+            event.begin_ns = now_ns();
+        }
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    ~Scope() {
+        if (event.begin_ns >= 0) {
+            event.end_ns = now_ns();
+            this_thread_ring().push(event);
+        }
+    }
+};
+
+inline void write_chrome_json(const std::string &path) {
+    auto escaped = [](const char *s) {
+        std::string rv;
+        for (; *s != '\0'; ++s) {
+            if (*s == '"' || *s == '\\') {
+                rv.push_back('\\');
+            }
+            rv.push_back(*s);
+        }
+        return rv;
+    };
+    std::ofstream os(path);
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    std::string sep{"\n"};
+    std::lock_guard lock{rings_mutex};
+    for (const auto &ring : rings) {
+        os << sep << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->tid
+           << ", \"args\": {\"name\": \"thread " << ring->tid << "\"}}";
+        sep = ",\n";
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+        for (uint64_t i = written > RING_CAPACITY ? written - RING_CAPACITY : 0; i < written; ++i) {
+            const Event &e = ring->events[i % RING_CAPACITY];
+            os << sep << "  {\"name\": \"" << escaped(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->tid
+               << ", \"ts\": " << e.begin_ns / 1e3 << ", \"dur\": " << (e.end_ns - e.begin_ns) / 1e3;
+            if (e.arg_names[0] != nullptr) {
+                os << ", \"args\": {\"" << escaped(e.arg_names[0]) << "\": " << e.args[0];
+                if (e.arg_names[1] != nullptr) {
+                    os << ", \"" << escaped(e.arg_names[1]) << "\": " << e.args[1];
+                }
+                os << "}";
+            }
+            os << "}";
+        }
+    }
+    os << "\n]}\n";
+}
+
+} // namespace Trace
+} // namespace Utils
+
+#define UTILS_TRACE_CONCAT_INNER(a, b) a##b
+#define UTILS_TRACE_CONCAT(a, b) UTILS_TRACE_CONCAT_INNER(a, b)
+#ifdef UTILS_NO_TRACE
+#define UTILS_TRACE_SCOPE(...) ((void)0)
+#else
+#define UTILS_TRACE_SCOPE(...) const Utils::Trace::Scope UTILS_TRACE_CONCAT(utils_trace_scope_, __LINE__)(__VA_ARGS__)
+#endif
@@ -2,15 +2,49 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <locale>
+#include <map>
 #include <numeric>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <filesystem>
 
+#include "AllocTracker.h"
+#include "PerfCounters.h"
+#include "ThreadPool.h"
+#include "Tokenizer.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Utils {
 
 const bool BENCH_DISPLAY_INITIAL_RUNS = false;
@@ -42,32 +76,273 @@ inline std::string find_filename(const std::string& filename) {
     }
 }
 
-inline std::string read_file(const std::string &filename) {
-    const int BUF_SIZE = 100000;
-    static char buf[BUF_SIZE];
-    std::ifstream ins(find_filename(filename));
-    ins.read(buf, BUF_SIZE - 1);
-    buf[ins.gcount()] = 0;
-    return std::string{buf};
+// Read-only memory mapping of a whole input file. Never copies the contents; the
+// mapping lives as long as the MappedFile does.
+struct MappedFile {
+    const char *data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept { swap(other); }
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        MappedFile{std::move(other)}.swap(*this);
+        return *this;
+    }
+    ~MappedFile() { close(); }
+
+    void swap(MappedFile &other) noexcept {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#endif
+    }
+
+    std::string_view view() const {
+        return {data, size};
+    }
+
+    static MappedFile open(const std::string &filename) {
+        const std::string path = find_filename(filename);
+        MappedFile rv;
+#ifdef _WIN32
+        rv.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER file_size{};
+        if (rv.file == INVALID_HANDLE_VALUE || !GetFileSizeEx(rv.file, &file_size)) {
+            std::cerr << "ERROR: Unable to open filename: " << path << "\n";
+            abort();
+        }
+        rv.size = static_cast<std::size_t>(file_size.QuadPart);
+        if (rv.size == 0) {
+            return rv;
+        }
+        rv.mapping = CreateFileMappingA(rv.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (rv.mapping != nullptr) {
+            rv.data = static_cast<const char *>(MapViewOfFile(rv.mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st {};
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::cerr << "ERROR: Unable to open filename: " << path << "\n";
+            abort();
+        }
+        rv.size = static_cast<std::size_t>(st.st_size);
+        if (rv.size == 0) {
+            ::close(fd);
+            return rv;
+        }
+        void *p = mmap(nullptr, rv.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p != MAP_FAILED) {
+            madvise(p, rv.size, MADV_SEQUENTIAL);
+            rv.data = static_cast<const char *>(p);
+        }
+#endif
+        if (rv.data == nullptr) {
+            std::cerr << "ERROR: Unable to map filename: " << path << "\n";
+            abort();
+        }
+        return rv;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (data != nullptr) {
+            munmap(const_cast<char *>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+    }
+};
+
+// Non-owning view over a solver's input, read through tokenizer(). str() mirrors
+// std::istringstream::str() so solvers can switch over with minimal churn.
+struct InputView {
+    std::string_view data;
+
+    std::string_view str() const {
+        return data;
+    }
+
+    std::size_t size() const {
+        return data.size();
+    }
+
+    Tokenizer tokenizer() const {
+        return {data};
+    }
+};
+
+// Input file kept mapped for as long as it's needed; hands out views without copying.
+struct InputFile {
+    MappedFile mapped;
+
+    static InputFile open(const std::string &filename) {
+        return {MappedFile::open(filename)};
+    }
+
+    InputView view() const {
+        return {mapped.view()};
+    }
+};
+
+// Solvers that take a `const InputView &` get the mapped input directly. Solvers that
+// still take `std::istringstream &` keep working through this shim, at the cost of the
+// one copy into the stream they always had.
+template <typename Solver, typename Output>
+void run_solver(Solver &solver, const InputView &input, Output &os) {
+    if constexpr (std::is_invocable_v<Solver &, std::istringstream &, Output &>) {
+        std::istringstream iss{std::string{input.data}};
+        solver(iss, os);
+    } else {
+        solver(input, os);
+    }
+}
+
+using ErasedSolver = std::function<void(const InputView &, std::ostringstream &)>;
+
+// Counts the units of work in an input (transmissions, lines...), so a bench can report
+// a rate in them next to its MB/s.
+struct ItemCount {
+    std::string unit;
+    std::function<int64_t(const InputView &)> count;
+};
+
+inline ErasedSolver erase_solver(auto solver) {
+    return [solver](const InputView &input, std::ostringstream &os) mutable {
+        run_solver(solver, input, os);
+    };
 }
 
+// Stream buffer swapped into std::cout while cases run in parallel. Threads that set
+// `capture` write into their own string; everyone else goes straight to the original
+// buffer, so the main thread can keep printing while workers run.
+struct CoutCaptureBuf : std::streambuf {
+    static inline thread_local std::string *capture = nullptr;
+
+    std::streambuf *original;
+
+    explicit CoutCaptureBuf(std::streambuf *original) : original(original) {}
+
+  protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        if (capture != nullptr) {
+            capture->push_back(traits_type::to_char_type(ch));
+            return ch;
+        }
+        return original->sputc(traits_type::to_char_type(ch));
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        if (capture != nullptr) {
+            capture->append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+        return original->sputn(s, n);
+    }
+
+    int sync() override {
+        return capture != nullptr ? 0 : original->pubsync();
+    }
+};
+
+// Cases are queued by test() and run by run() (or summarize()) on a pool of `jobs`
+// threads. Each input file is mapped once and shared by every case that reads it, and
+// whatever a solver prints to std::cout is held back and printed with its own case, in
+// the order the cases were declared.
 struct Tester {
     std::string base_dir;
     std::vector<std::tuple<std::string, bool, std::string>> results;
+    bool summarized = false;
+    int jobs = ThreadPool::default_thread_count();
+
+    struct PendingCase {
+        std::string display_name, path, expected;
+        ErasedSolver solver;
+    };
+    std::vector<PendingCase> pending;
+
     void test(const std::string &display_prefix, const std::string &name,
               const std::string &expected, auto solver) {
         std::ostringstream display_name;
         display_name << base_dir << ":" << display_prefix << ":" << name;
-        std::cout << ">==  " << display_name.str() << "  ==<\n";
-        std::string input = read_file(base_dir + "/" + name);
-        std::istringstream iss{input};
-        std::ostringstream oss;
-        solver(iss, oss);
-        const std::string &output = oss.str();
+        pending.push_back({display_name.str(), base_dir + "/" + name, expected, erase_solver(solver)});
+    }
+
+    void run() {
+        if (pending.empty()) {
+            return;
+        }
+        std::map<std::string, InputFile> inputs;
+        for (const auto &c : pending) {
+            if (!inputs.contains(c.path)) {
+                inputs.emplace(c.path, InputFile::open(c.path));
+            }
+        }
 
-        std::cout << "RESULT (" << display_name.str() << "): ";
+        struct Outcome {
+            std::string output, captured;
+        };
+        CoutCaptureBuf capture_buf{std::cout.rdbuf()};
+        std::cout.rdbuf(&capture_buf);
+        {
+            ThreadPool pool{std::min(jobs, static_cast<int>(pending.size()))};
+            std::vector<std::future<Outcome>> outcomes;
+            for (const auto &c : pending) {
+                outcomes.push_back(pool.submit([&c, &inputs]() {
+                    const Trace::Scope scope{Trace::enabled() ? Trace::intern(c.display_name) : ""};
+                    Outcome rv;
+                    CoutCaptureBuf::capture = &rv.captured;
+                    std::ostringstream oss;
+                    c.solver(inputs.at(c.path).view(), oss);
+                    std::cout.flush();
+                    CoutCaptureBuf::capture = nullptr;
+                    rv.output = oss.str();
+                    return rv;
+                }));
+            }
+            for (std::size_t i = 0; i < pending.size(); ++i) {
+                const Outcome outcome = outcomes[i].get();
+                report(pending[i], outcome.output, outcome.captured);
+            }
+        }
+        std::cout.rdbuf(capture_buf.original);
+        pending.clear();
+    }
+
+    void report(const PendingCase &c, const std::string &output, const std::string &captured) {
+        std::cout << ">==  " << c.display_name << "  ==<\n";
+        std::cout << captured;
+        if (!captured.empty() && captured.back() != '\n') {
+            std::cout << "\n";
+        }
+        std::cout << "RESULT (" << c.display_name << "): ";
         std::ostringstream msg;
-        bool ok = output == expected;
+        bool ok = output == c.expected;
 
         auto shorten = [](const std::string &s) {
             auto lim = s.length();
@@ -86,12 +361,15 @@ struct Tester {
         if (ok) {
             msg << "OK!   got " << shorten(output);
         } else {
-            msg << "FAIL! got " << shorten(output) << " expected " << shorten(expected);
+            msg << "FAIL! got " << shorten(output) << " expected " << shorten(c.expected);
         }
-        std::cout << msg.str() << "\n";
-        results.push_back({display_name.str(), ok, msg.str()});
+        std::cout << msg.str() << std::endl;
+        results.push_back({c.display_name, ok, msg.str()});
     }
-    ~Tester() {
+
+    bool summarize() {
+        run();
+        summarized = true;
         std::cout << "\n>=====  RESULT SUMMARY  =====<\n";
         bool all_ok = true;
         for (const auto &[name, ok, msg] : results) {
@@ -103,37 +381,269 @@ struct Tester {
         std::cout << "\n";
         if (!all_ok) {
             std::cout << "FAILED A TEST!\n";
+        }
+        return all_ok;
+    }
+    ~Tester() {
+        if (!summarized && !summarize()) {
             exit(1);
         }
     }
 };
 
-void bench(const std::string &base_dir, const std::string &display_prefix, const std::string &name, const std::string &expected,
-           int iterations, auto solver) {
+// Pins the calling thread to one CPU and restores its previous affinity on destruction.
+// A negative cpu means whichever CPU the thread is on right now.
+struct ScopedCpuPin {
+    bool pinned = false;
+    int cpu = -1;
+#if defined(_WIN32)
+    DWORD_PTR previous_mask = 0;
+#elif defined(__linux__)
+    cpu_set_t previous_set{};
+#endif
+
+    explicit ScopedCpuPin(int requested_cpu) {
+#if defined(_WIN32)
+        cpu = requested_cpu >= 0 ? requested_cpu : static_cast<int>(GetCurrentProcessorNumber());
+        if (cpu < static_cast<int>(8 * sizeof(DWORD_PTR))) {
+            previous_mask = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu);
+            pinned = previous_mask != 0;
+        }
+#elif defined(__linux__)
+        cpu = requested_cpu >= 0 ? requested_cpu : sched_getcpu();
+        if (cpu >= 0 && pthread_getaffinity_np(pthread_self(), sizeof(previous_set), &previous_set) == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        }
+#endif
+    }
+    ScopedCpuPin(const ScopedCpuPin &) = delete;
+    ScopedCpuPin &operator=(const ScopedCpuPin &) = delete;
+    ~ScopedCpuPin() {
+        if (!pinned) {
+            return;
+        }
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), previous_mask);
+#elif defined(__linux__)
+        pthread_setaffinity_np(pthread_self(), sizeof(previous_set), &previous_set);
+#endif
+    }
+};
+
+struct BenchOptions {
+    int iterations = 100;
+    // Stop early once this much wall time has been spent; at least one iteration always runs.
+    double budget_seconds = std::numeric_limits<double>::infinity();
+    // Read hardware counters around every solver call (Linux perf_event_open).
+    bool perf_counters = false;
+    // Count heap allocations per solver call (needs the hooks in AllocTracker.cpp).
+    bool track_allocations = false;
+    // Adaptive mode: pin to a CPU, run unrecorded warmup iterations until timings settle,
+    // then sample until the 95% confidence interval of the median is within +-target_ci
+    // of it, or the iteration cap or budget runs out. Far-out outliers are reported
+    // separately instead of being folded into the percentiles.
+    bool adaptive = false;
+    double target_ci = 0.01;
+    int min_samples = 10;
+    int max_warmup_iterations = 200;
+    int pin_cpu = -1;
+};
+
+// Percentiles over an ascending-sorted, non-empty sample.
+inline double p_min_of(const std::vector<double> &v) { return v.front(); }
+inline double p5_of(const std::vector<double> &v) { return v[std::ssize(v) / 20]; }
+inline double p50_of(const std::vector<double> &v) { return v[std::ssize(v) / 2]; }
+inline double p95_of(const std::vector<double> &v) { return v[std::min(std::ssize(v) - std::ssize(v) / 20, std::ssize(v) - 1)]; }
+inline double p_max_of(const std::vector<double> &v) { return v.back(); }
+
+// Distribution-free 95% confidence interval of the median, from order statistics.
+inline std::tuple<double, double> median_ci95_of(const std::vector<double> &v) {
+    const double n = static_cast<double>(v.size());
+    const double half_width = 1.96 * std::sqrt(n) / 2;
+    auto at = [&](double rank) {
+        return v[static_cast<std::size_t>(std::clamp(rank, 0.0, n - 1))];
+    };
+    return {at(std::floor(n / 2 - half_width)), at(std::ceil(n / 2 + half_width))};
+}
+
+// Moves values beyond Tukey's far-out fences (3 IQR past the quartiles) from the sorted
+// sample into the returned vector.
+inline std::vector<double> split_outliers(std::vector<double> &v) {
+    if (std::ssize(v) < 4) {
+        return {};
+    }
+    const double q1 = v[std::ssize(v) / 4], q3 = v[std::ssize(v) * 3 / 4];
+    const double lo = q1 - 3 * (q3 - q1), hi = q3 + 3 * (q3 - q1);
+    std::vector<double> outliers, kept;
+    for (double x : v) {
+        (lo <= x && x <= hi ? kept : outliers).push_back(x);
+    }
+    v = std::move(kept);
+    return outliers;
+}
+
+struct BenchResult {
+    std::string base_dir, display_prefix, name;
+    std::vector<double> timings; // microseconds, sorted ascending
+    // Per-iteration values of hardware counters and allocation stats, each sorted
+    // ascending; only metrics that produced a value on every iteration are kept.
+    std::vector<std::tuple<std::string, std::vector<double>>> metrics;
+    // The solver ran tasks on ThreadPool::shared() while counters were on, and those
+    // workers aren't counted, so the counter metrics only cover the calling thread.
+    bool counters_calling_thread_only = false;
+    int64_t peak_rss_bytes = 0; // 0 when unknown
+    int64_t input_bytes = 0;
+    int64_t items = 0; // 0 when the case has no ItemCount
+    std::string item_unit;
+    // Adaptive mode only.
+    std::vector<double> outliers; // microseconds, sorted ascending, excluded from timings
+    int warmup_iterations = 0;
+    bool converged = false;
+
+    double p_min() const { return p_min_of(timings); }
+    double p5() const { return p5_of(timings); }
+    double p50() const { return p50_of(timings); }
+    double p95() const { return p95_of(timings); }
+    double p_max() const { return p_max_of(timings); }
+};
+
+BenchResult bench(const std::string &base_dir, const std::string &display_prefix, const std::string &name, const std::string &expected,
+                  const BenchOptions &options, auto solver, const ItemCount &item_count = {}) {
     using clock = std::chrono::high_resolution_clock;
 
     std::ostringstream display_name;
     display_name << base_dir << ":" << display_prefix << ":" << name;
+    const Trace::Scope trace_scope{Trace::enabled() ? Trace::intern("bench " + display_name.str()) : ""};
 
     std::cout << ">=====  BENCH  =====<\n";
-    std::cout << "  Running " << iterations << " iterations of " << display_name.str() << "...\n";
-    std::string input{read_file(base_dir + "/" + name)};
+    if (options.adaptive) {
+        std::cout << "  Running " << display_name.str() << " until its median is within +-" << std::fixed << std::setprecision(1) << options.target_ci * 100 << "% (at most "
+                  << options.iterations << " iterations)...\n";
+    } else {
+        std::cout << "  Running " << options.iterations << " iterations of " << display_name.str() << "...\n";
+    }
+    const InputFile input{InputFile::open(base_dir + "/" + name)};
     std::vector<double> timings;
-    timings.reserve(iterations);
-    for (int i = 0; i < iterations; ++i) {
-        std::istringstream iss{input};
+    timings.reserve(std::min(options.iterations, 1 << 16));
+
+    PerfCounters counters;
+    std::vector<PerfCounters::Sample> counter_samples;
+    bool counters_calling_thread_only = false;
+    if (options.perf_counters) {
+        counters = PerfCounters::open();
+        if (!counters.available()) {
+            std::cout << "  Hardware counters unavailable (" << counters.unavailable_reason << "), timing only.\n";
+        } else if (!counters.unavailable_reason.empty()) {
+            std::cout << "  Some hardware counters unavailable (" << counters.unavailable_reason << ").\n";
+        }
+        counter_samples.reserve(std::min(options.iterations, 1 << 16));
+    }
+
+    std::vector<AllocTracker::Stats> alloc_samples;
+    if (options.track_allocations) {
+        if (!AllocTracker::installed()) {
+            std::cout << "  Allocation hooks not linked in, not tracking allocations.\n";
+        }
+        alloc_samples.reserve(std::min(options.iterations, 1 << 16));
+    }
+    const bool track_allocations = options.track_allocations && AllocTracker::installed();
+    const bool peak_rss_is_per_bench = reset_peak_rss();
+
+    std::optional<ScopedCpuPin> pin;
+    if (options.adaptive) {
+        pin.emplace(options.pin_cpu);
+        if (pin->pinned) {
+            std::cout << "  Pinned to CPU " << pin->cpu << ".\n";
+        } else {
+            std::cout << "  Unable to pin to a CPU, running unpinned.\n";
+        }
+    }
+
+    auto run_once = [&](bool recorded) {
         std::ostringstream oss;
+        const int64_t pool_tasks_before = ThreadPool::shared().submitted_count();
+        if (recorded && counters.available()) {
+            counters.start();
+        }
+        if (recorded && track_allocations) {
+            AllocTracker::start();
+        }
         auto start = clock::now();
-        solver(iss, oss);
+        run_solver(solver, input.view(), oss);
         auto end = clock::now();
+        if (recorded && track_allocations) {
+            alloc_samples.push_back(AllocTracker::stop());
+        }
+        if (recorded && counters.available()) {
+            counter_samples.push_back(counters.stop());
+            if (ThreadPool::shared().submitted_count() != pool_tasks_before) {
+                counters_calling_thread_only = true;
+            }
+        }
         const std::string &output{oss.str()};
         if (output != expected) {
             std::cout << "!!! Wrong answer !!!\n";
             abort();
         }
-        timings.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000.);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000.;
+    };
+
+    const auto bench_start = clock::now();
+    auto out_of_budget = [&]() {
+        return std::chrono::duration<double>(clock::now() - bench_start).count() >= options.budget_seconds;
+    };
+
+    int warmup_iterations = 0;
+    if (options.adaptive) {
+        // Warm up until the median of the last 5 runs is within 5% of the 5 before them.
+        std::vector<double> recent;
+        auto median5 = [](std::vector<double> v) {
+            std::nth_element(v.begin(), v.begin() + 2, v.end());
+            return v[2];
+        };
+        while (warmup_iterations < options.max_warmup_iterations && !out_of_budget()) {
+            recent.push_back(run_once(false));
+            ++warmup_iterations;
+            if (std::ssize(recent) >= 10) {
+                double newer = median5({recent.end() - 5, recent.end()});
+                double older = median5({recent.end() - 10, recent.end() - 5});
+                if (std::abs(newer - older) <= 0.05 * older) {
+                    break;
+                }
+            }
+        }
+    }
+
+    bool converged = false;
+    auto next_convergence_check = options.min_samples;
+    for (int i = 0; i < options.iterations; ++i) {
+        timings.push_back(run_once(true));
+        if (out_of_budget()) {
+            break;
+        }
+        if (options.adaptive && std::ssize(timings) >= next_convergence_check) {
+            std::vector<double> sorted{timings};
+            std::sort(sorted.begin(), sorted.end());
+            split_outliers(sorted);
+            const auto [ci_low, ci_high] = median_ci95_of(sorted);
+            if (ci_high - ci_low <= 2 * options.target_ci * p50_of(sorted)) {
+                converged = true;
+                break;
+            }
+            next_convergence_check = static_cast<int>(std::ssize(timings) + std::ssize(timings) / 8 + 1);
+        }
     }
-    std::cout << "  Done.\n";
+    std::cout << "  Done";
+    if (options.adaptive) {
+        std::cout << " (" << (converged ? "converged" : "did not converge") << " after " << warmup_iterations << " warmup + "
+                  << std::ssize(timings) << " iterations)";
+    } else if (std::ssize(timings) < options.iterations) {
+        std::cout << " (time budget reached after " << std::ssize(timings) << " iterations)";
+    }
+    std::cout << ".\n";
 
     if (BENCH_DISPLAY_INITIAL_RUNS) {
         std::cout << "\n";
@@ -146,13 +656,114 @@ void bench(const std::string &base_dir, const std::string &display_prefix, const
     }
 
     std::sort(timings.begin(), timings.end());
+    BenchResult rv;
+    rv.base_dir = base_dir;
+    rv.display_prefix = display_prefix;
+    rv.name = name;
+    rv.timings = std::move(timings);
+    rv.input_bytes = std::ssize(input.view().str());
+    rv.counters_calling_thread_only = counters_calling_thread_only;
+    if (item_count.count) {
+        rv.items = item_count.count(input.view());
+        rv.item_unit = item_count.unit;
+    }
+    if (options.adaptive) {
+        rv.outliers = split_outliers(rv.timings);
+        rv.warmup_iterations = warmup_iterations;
+        rv.converged = converged;
+    }
     std::cout << "\n";
     std::cout << std::fixed << std::setprecision(1);
-    std::cout << "  pMin: " << std::setw(7) << timings[0] << " us\n";
-    std::cout << "  p5  : " << std::setw(7) << timings[std::ssize(timings) / 20] << " us\n";
-    std::cout << "  p50 : " << std::setw(7) << timings[std::ssize(timings) / 2] << " us\n";
-    std::cout << "  p95 : " << std::setw(7) << timings[std::min(std::ssize(timings) - std::ssize(timings) / 20, std::ssize(timings) - 1)] << " us\n";
-    std::cout << "  pMax: " << std::setw(7) << timings[std::ssize(timings) - 1] << " us\n";
+    std::cout << "  pMin: " << std::setw(7) << rv.p_min() << " us\n";
+    std::cout << "  p5  : " << std::setw(7) << rv.p5() << " us\n";
+    std::cout << "  p50 : " << std::setw(7) << rv.p50() << " us\n";
+    std::cout << "  p95 : " << std::setw(7) << rv.p95() << " us\n";
+    std::cout << "  pMax: " << std::setw(7) << rv.p_max() << " us\n";
+    if (rv.p50() > 0) {
+        std::cout << "  throughput at p50: " << rv.input_bytes / rv.p50() << " MB/s";
+        if (rv.items > 0) {
+            std::cout << ", " << std::setprecision(0) << rv.items / (rv.p50() / 1e6) << " " << rv.item_unit << "/s"
+                      << std::setprecision(1);
+        }
+        std::cout << "\n";
+    }
+    if (options.adaptive) {
+        const auto [ci_low, ci_high] = median_ci95_of(rv.timings);
+        std::cout << "  p50 95% CI: [" << ci_low << ", " << ci_high << "] us\n";
+        if (!rv.outliers.empty()) {
+            std::cout << "  outliers: " << std::ssize(rv.outliers) << " (";
+            std::string sep{""};
+            for (int i = 0; i < std::min<int>(5, static_cast<int>(std::ssize(rv.outliers))); ++i) {
+                std::cout << sep << rv.outliers[std::ssize(rv.outliers) - 1 - i];
+                sep = ", ";
+            }
+            std::cout << (std::ssize(rv.outliers) > 5 ? ", ..." : "") << " us)\n";
+        }
+    }
+
+    auto collect = [&rv](const std::string &metric_name, const auto &samples, auto value_of) {
+        std::vector<double> values;
+        for (const auto &sample : samples) {
+            std::optional<double> v = value_of(sample);
+            if (!v.has_value()) {
+                return;
+            }
+            values.push_back(*v);
+        }
+        std::sort(values.begin(), values.end());
+        rv.metrics.push_back({metric_name, std::move(values)});
+    };
+    if (!counter_samples.empty()) {
+        for (int c = 0; c < PerfCounters::COUNT; ++c) {
+            collect(PerfCounters::names[c], counter_samples, [c](const PerfCounters::Sample &s) { return s[c]; });
+            if (c == PerfCounters::Instructions) {
+                collect("IPC", counter_samples, [](const PerfCounters::Sample &s) -> std::optional<double> {
+                    if (!s[PerfCounters::Cycles] || !s[PerfCounters::Instructions] || *s[PerfCounters::Cycles] == 0) {
+                        return std::nullopt;
+                    }
+                    return *s[PerfCounters::Instructions] / *s[PerfCounters::Cycles];
+                });
+            }
+        }
+    }
+    if (!alloc_samples.empty()) {
+        collect("allocs", alloc_samples, [](const AllocTracker::Stats &s) { return static_cast<double>(s.allocations); });
+        collect("alloc-bytes", alloc_samples, [](const AllocTracker::Stats &s) { return static_cast<double>(s.bytes); });
+        collect("peak-live-bytes", alloc_samples, [](const AllocTracker::Stats &s) { return static_cast<double>(s.peak_live_bytes); });
+    }
+
+    if (!rv.metrics.empty()) {
+        std::cout << "\n  " << std::setw(15) << "metric" << std::setw(14) << "pMin" << std::setw(14) << "p5" << std::setw(14) << "p50"
+                  << std::setw(14) << "p95" << std::setw(14) << "pMax" << "\n";
+        auto is_counter = [](const std::string &metric_name) {
+            return metric_name == "IPC" ||
+                   std::find(PerfCounters::names.begin(), PerfCounters::names.end(), metric_name) != PerfCounters::names.end();
+        };
+        for (const auto &[metric_name, values] : rv.metrics) {
+            const bool marked = rv.counters_calling_thread_only && is_counter(metric_name);
+            std::cout << std::setprecision(metric_name == "IPC" ? 2 : 0);
+            std::cout << "  " << std::setw(15) << (marked ? metric_name + "*" : metric_name) << std::setw(14) << p_min_of(values) << std::setw(14) << p5_of(values)
+                      << std::setw(14) << p50_of(values) << std::setw(14) << p95_of(values) << std::setw(14) << p_max_of(values) << "\n";
+        }
+        if (rv.counters_calling_thread_only) {
+            std::cout << "  * calling thread only: the solver also ran tasks on the shared pool, whose workers aren't counted\n";
+        }
+        std::cout << std::setprecision(1);
+    }
+
+    if (options.track_allocations) {
+        rv.peak_rss_bytes = Utils::peak_rss_bytes();
+        if (rv.peak_rss_bytes > 0) {
+            std::cout << "\n  peak RSS" << (peak_rss_is_per_bench ? "" : " (whole process)") << ": "
+                      << rv.peak_rss_bytes / (1024. * 1024.) << " MiB\n";
+        }
+    }
+    return rv;
+}
+
+BenchResult bench(const std::string &base_dir, const std::string &display_prefix, const std::string &name, const std::string &expected,
+                  int iterations, auto solver) {
+    return bench(base_dir, display_prefix, name, expected, BenchOptions{iterations}, solver);
 }
 
 } // namespace Utils
@@ -1,4 +1,7 @@
-#include "Utils.h"
+#include "CpuFeatures.h"
+#include "Registry.h"
+#include <array>
+#include <bit>
 
 namespace Day16A {
 
@@ -7,193 +10,868 @@ char htoi(char x) {
     return (x & 0xf) + (z | (z << 3));
 }
 
-std::vector<uint64_t> read_input(std::istringstream &is) {
-    std::vector<uint64_t> rv;
-    rv.reserve((is.str().length() + 15) / 16);
+bool is_hex(char c) {
+    return static_cast<unsigned char>(c - '0') < 10 || static_cast<unsigned char>((c | 0x20) - 'a') < 6;
+}
+
+// The decoders below turn hex digits into 64-bit words, first digit in the top nibble
+// of the first word, with the last word zero-padded on the right. `out` holds
+// (hex.size() + 15) / 16 words. Each returns false if it saw a non-hex character;
+// validity is OR-ed up across the whole buffer and checked once at the end.
+
+bool decode_hex_scalar(std::string_view hex, uint64_t *out) {
+    bool valid = true;
     uint64_t partial = 0;
     int partial_count = 0;
-    for (char c : is.str()) {
-        if (c >= '0') {
-            int v = htoi(c);
-            if (partial_count >= 64) {
-                rv.push_back(partial);
-                partial = partial_count = 0;
-            }
-            partial = (partial << 4) | v;
-            partial_count += 4;
+    for (char c : hex) {
+        valid &= is_hex(c);
+        partial = (partial << 4) | htoi(c);
+        partial_count += 4;
+        if (partial_count == 64) {
+            *out++ = partial;
+            partial = partial_count = 0;
         }
     }
     if (partial_count) {
-        rv.push_back(partial << (64 - partial_count));
+        *out = partial << (64 - partial_count);
+    }
+    return valid;
+}
+
+#ifdef UTILS_X86
+
+// 16 digits -> 16 nibbles -> 8 bytes in stream order -> one word, per 128-bit step:
+//   value     = (c & 0xf) + (c > '9' ? 9 : 0)
+//   bytes     = maddubs(value, {16, 1}) packs each digit pair into one byte
+//   word      = bytes reversed, since the first digit is the most significant
+UTILS_TARGET("ssse3")
+bool decode_hex_ssse3(std::string_view hex, uint64_t *out) {
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i a_char = _mm_set1_epi8('a');
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i pair_weights = _mm_set1_epi16(0x0110);
+    const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i invalid = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= hex.size(); i += 16, ++out) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hex.data() + i));
+        const __m128i digit = _mm_sub_epi8(v, zero_char);
+        const __m128i letter = _mm_sub_epi8(_mm_or_si128(v, case_bit), a_char);
+        const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+        const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, five), letter);
+        invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_letter), _mm_set1_epi8(-1)));
+
+        const __m128i value = _mm_add_epi8(_mm_and_si128(v, low_nibble), _mm_and_si128(is_letter, nine));
+        const __m128i pairs = _mm_maddubs_epi16(value, pair_weights);
+        const __m128i bytes = _mm_packus_epi16(pairs, pairs);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(bytes, reverse));
+    }
+    const bool tail_valid = decode_hex_scalar(hex.substr(i), out);
+    return tail_valid && _mm_movemask_epi8(invalid) == 0;
+}
+
+// Same as the SSSE3 path, 32 digits and two words per step.
+UTILS_TARGET("avx2")
+bool decode_hex_avx2(std::string_view hex, uint64_t *out) {
+    const __m256i zero_char = _mm256_set1_epi8('0');
+    const __m256i a_char = _mm256_set1_epi8('a');
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i five = _mm256_set1_epi8(5);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i pair_weights = _mm256_set1_epi16(0x0110);
+    const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             7, 6, 5, 4, 3, 2, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m256i invalid = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 32 <= hex.size(); i += 32, out += 2) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hex.data() + i));
+        const __m256i digit = _mm256_sub_epi8(v, zero_char);
+        const __m256i letter = _mm256_sub_epi8(_mm256_or_si256(v, case_bit), a_char);
+        const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, nine), digit);
+        const __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, five), letter);
+        invalid = _mm256_or_si256(invalid, _mm256_andnot_si256(_mm256_or_si256(is_digit, is_letter), _mm256_set1_epi8(-1)));
+
+        const __m256i value = _mm256_add_epi8(_mm256_and_si256(v, low_nibble), _mm256_and_si256(is_letter, nine));
+        const __m256i pairs = _mm256_maddubs_epi16(value, pair_weights);
+        // packus works per 128-bit lane: each lane's 8 bytes land in its low half
+        const __m256i bytes = _mm256_shuffle_epi8(_mm256_packus_epi16(pairs, pairs), reverse);
+        const __m256i words = _mm256_permute4x64_epi64(bytes, 0b1000);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(words));
+    }
+    const bool tail_valid = decode_hex_scalar(hex.substr(i), out);
+    return tail_valid && _mm256_movemask_epi8(invalid) == 0;
+}
+
+#endif
+
+using HexDecoder = bool (*)(std::string_view, uint64_t *);
+
+HexDecoder pick_hex_decoder() {
+#ifdef UTILS_X86
+    const auto &cpu = Utils::CpuFeatures::get();
+    if (cpu.avx2) {
+        return decode_hex_avx2;
+    }
+    if (cpu.ssse3) {
+        return decode_hex_ssse3;
     }
+#endif
+    return decode_hex_scalar;
+}
+
+HexDecoder hex_decoder() {
+    static const HexDecoder rv = pick_hex_decoder();
     return rv;
 }
 
-struct Parser {
-    const std::vector<uint64_t> &data_v;
-    int pos, subpos;
+// Packs a transmission into `words`, reusing its storage. There is one spare zero word
+// at the end so BitReader can always look at the word after the current one.
+void decode_into(std::string_view hex, std::vector<uint64_t> &words) {
+    words.resize((hex.size() + 15) / 16 + 1);
+    words.back() = 0;
+    if (!hex_decoder()(hex, words.data())) {
+        std::cerr << "ERROR: Transmission has a character that isn't a hex digit\n";
+        abort();
+    }
+}
+
+std::vector<uint64_t> read_input(const Utils::InputView &input) {
+    auto tokenizer = input.tokenizer();
+    std::vector<uint64_t> rv;
+    decode_into(tokenizer.expect_word(), rv);
+    return rv;
+}
+
+// MSB-first bit fields out of the packed words. Every read looks at the 128-bit window
+// made of the word holding the current bit and the one after it, so a field of any width
+// from 1 to 64 bits comes out of two loads and two shifts, with no branch on where the
+// word boundary falls. Needs one readable word past the last one holding data.
+struct BitReader {
+    const uint64_t *words;
+    int64_t pos = 0;
 
-    int version_sum = 0;
+    uint64_t peek64() const {
+        const uint64_t *w = words + (pos >> 6);
+        const int shift = static_cast<int>(pos & 63);
+        // (w[1] >> 1) >> (63 - shift) is w[1] >> (64 - shift) minus the shift by 64 at 0
+        return (w[0] << shift) | ((w[1] >> 1) >> (63 - shift));
+    }
+
+    uint64_t peek(int width) const {
+        return peek64() >> (64 - width);
+    }
 
-    static Parser make(const std::vector<uint64_t> &start) {
-        return {start, 0, 0};
+    void skip(int width) {
+        pos += width;
     }
 
-    std::ostream &indented(std::ostream &os, int depth) {
-        for (int i = 0; i < depth; ++i) {
-            os << "  ";
+    uint64_t read(int width) {
+        uint64_t rv = peek(width);
+        skip(width);
+        return rv;
+    }
+};
+
+// Continuation bits of the first 12 five-bit literal groups in a peek64() window.
+constexpr uint64_t LITERAL_CONTINUATION_BITS = []() {
+    uint64_t rv = 0;
+    for (int g = 0; g < 12; ++g) {
+        rv |= uint64_t{1} << (63 - 5 * g);
+    }
+    return rv;
+}();
+
+// Value of the literal whose first group is at the reader. The group count is where the
+// first clear continuation bit is; only literals of more than 12 groups (48 bits) need
+// the group-at-a-time loop.
+int64_t read_literal(BitReader &reader) {
+    const uint64_t window = reader.peek64();
+    const uint64_t stops = ~window & LITERAL_CONTINUATION_BITS;
+    if (stops == 0) {
+        int64_t v = 0;
+        while (true) {
+            uint64_t x = reader.read(5);
+            v = (v << 4) | static_cast<int64_t>(x & 0xf);
+            if (!(x & 0x10)) {
+                return v;
+            }
         }
-        return os;
+    }
+    const int groups = std::countl_zero(stops) / 5 + 1;
+    int64_t v = 0;
+    for (int g = 0; g < groups; ++g) {
+        v = (v << 4) | static_cast<int64_t>((window >> (59 - 5 * g)) & 0xf);
+    }
+    reader.skip(5 * groups);
+    return v;
+}
+
+// Operator semantics shared by every evaluator. Types 0-3 fold all subpackets starting
+// from operator_init; types 5-7 compare exactly two.
+int64_t operator_init(int type) {
+    switch (type) {
+    case 0:
+        return 0;
+    case 1:
+        return 1;
+    case 2:
+        return std::numeric_limits<int64_t>::max();
+    case 3:
+        return std::numeric_limits<int64_t>::min();
+    }
+    return 0;
+}
+
+int64_t operator_fold(int type, int64_t acc, int64_t v) {
+    switch (type) {
+    case 0:
+        return acc + v;
+    case 1:
+        return acc * v;
+    case 2:
+        return std::min(acc, v);
+    }
+    return std::max(acc, v);
+}
+
+int64_t operator_compare(int type, int64_t left, int64_t right) {
+    if (type == 5) {
+        return left > right;
+    } else if (type == 6) {
+        return left < right;
+    }
+    return left == right;
+}
+
+struct Packet {
+    int64_t bit_offset;
+    int32_t end;         // one past the last packet of this subtree
+    int32_t child_count;
+    uint8_t version, type;
+    int64_t literal;     // type 4 only
+};
+
+// Flat index of a whole transmission, built in one pass without recursion. Packets are
+// stored in preorder, so a subtree is the contiguous range [i, packets[i].end): the
+// first child of i is i + 1 and each next sibling starts at the previous one's end.
+// Parsing once lets callers evaluate, re-evaluate or query the tree as often as they
+// like; evaluation walks a range backwards, so children are always done before their
+// parent and nesting depth never touches the call stack.
+struct PacketIndex {
+    struct Open {
+        int32_t index;
+        bool by_length;
+        int64_t limit; // end bit for length type 0, subpacket count for type 1
+    };
+
+    std::vector<Packet> packets;
+    std::vector<Open> open; // parse scratch
+
+    static PacketIndex build(const std::vector<uint64_t> &words) {
+        UTILS_TRACE_SCOPE("PacketIndex::build");
+        PacketIndex rv;
+        rv.parse(words);
+        return rv;
+    }
+
+    // Replaces the index with the transmission in `words` (as laid out by decode_into),
+    // reusing the storage of the previous one.
+    void parse(const std::vector<uint64_t> &words) {
+        // the last word is decode_into's padding
+        const int64_t bit_count = 64 * (std::ssize(words) - 1);
+        packets.clear();
+        open.clear();
+        // typical transmissions spend a few dozen bits per packet
+        packets.reserve(bit_count / 32 + 1);
+        BitReader reader{words.data()};
+        do {
+            if (reader.pos + 11 > bit_count) {
+                std::cerr << "ERROR: Transmission ends in the middle of a packet\n";
+                abort();
+            }
+            const int32_t index = static_cast<int32_t>(packets.size());
+            if (!open.empty()) {
+                ++packets[open.back().index].child_count;
+            }
+            Packet &packet = packets.emplace_back();
+            packet.bit_offset = reader.pos;
+            packet.version = static_cast<uint8_t>(reader.read(3));
+            packet.type = static_cast<uint8_t>(reader.read(3));
+            if (packet.type == 4) {
+                packet.literal = read_literal(reader);
+                packet.end = index + 1;
+            } else if (reader.read(1)) {
+                open.push_back({index, false, static_cast<int64_t>(reader.read(11))});
+            } else {
+                const int64_t length = static_cast<int64_t>(reader.read(15));
+                open.push_back({index, true, reader.pos + length});
+            }
+
+            while (!open.empty()) {
+                const Open &top = open.back();
+                Packet &parent = packets[top.index];
+                if (top.by_length ? reader.pos < top.limit : parent.child_count < top.limit) {
+                    break;
+                }
+                if (top.by_length && reader.pos > top.limit) {
+                    std::cerr << "ERROR: Subpackets overrun their parent's length at bit " << reader.pos << "\n";
+                    abort();
+                }
+                parent.end = static_cast<int32_t>(packets.size());
+                open.pop_back();
+            }
+        } while (!open.empty());
     }
 
-    int get() {
-        int rv = bool(data_v[pos] & (uint64_t{1} << (63 - subpos)));
-        ++subpos;
-        if (subpos == 64) {
-            subpos = 0;
-            ++pos;
+    int64_t size() const {
+        return std::ssize(packets);
+    }
+
+    int64_t version_sum() const {
+        int64_t rv = 0;
+        for (const auto &packet : packets) {
+            rv += packet.version;
         }
         return rv;
     }
 
-    int getpos() {
-        return pos * 64 + subpos;
+    std::array<int64_t, 8> type_counts() const {
+        std::array<int64_t, 8> rv{};
+        for (const auto &packet : packets) {
+            ++rv[packet.type];
+        }
+        return rv;
     }
 
-    int read(const int original_count) {
-        int remaining = original_count;
-        int v = 0;
-        while (remaining) {
-            int chunk_clamp = 64 - subpos;
-            int chunk = std::min(remaining, chunk_clamp);
-            remaining -= chunk;
-            int chunk_bits = (data_v[pos] >> (64 - chunk - subpos)) & ((uint64_t{1} << chunk) - 1);
-            v = (v << chunk) | chunk_bits;
-            subpos += chunk;
-            if (subpos == 64) {
-                subpos = 0;
-                ++pos;
+    // Value of packet i from the already evaluated values of its children.
+    int64_t evaluate_node(int32_t i, const int64_t *values) const {
+        const Packet &packet = packets[i];
+        if (packet.type == 4) {
+            return packet.literal;
+        }
+        if (packet.type < 4) {
+            int64_t acc = operator_init(packet.type);
+            for (int32_t c = i + 1; c < packet.end; c = packets[c].end) {
+                acc = operator_fold(packet.type, acc, values[c]);
             }
+            return acc;
+        }
+        if (packet.child_count != 2) {
+            std::cerr << "ERROR: Comparison packet at bit " << packet.bit_offset << " has " << packet.child_count
+                      << " subpackets\n";
+            abort();
         }
-        return v;
+        return operator_compare(packet.type, values[i + 1], values[packets[i + 1].end]);
     }
 
-    int64_t parse_packet() {
-        int version = read(3);
-        int type = read(3);
+    void evaluate_range(int32_t begin, int32_t end, int64_t *values) const {
+        for (int32_t i = end - 1; i >= begin; --i) {
+            values[i] = evaluate_node(i, values);
+        }
+    }
+
+    // Values of every packet; values[0] is the transmission's.
+    std::vector<int64_t> evaluate() const {
+        UTILS_TRACE_SCOPE("PacketIndex::evaluate", "packets", size());
+        std::vector<int64_t> values;
+        evaluate_into(values);
+        return values;
+    }
 
-        version_sum += version;
+    void evaluate_into(std::vector<int64_t> &values) const {
+        values.resize(packets.size());
+        evaluate_range(0, static_cast<int32_t>(packets.size()), values.data());
+    }
 
-        if (type == 4) {
-            return parse_literal();
-        } else if (type == 0) {
-            return parse_operator_acc(0, [](int64_t acc, int64_t v) { return acc + v; });
-        } else if (type == 1) {
-            return parse_operator_acc(1, [](int64_t acc, int64_t v) { return acc * v; });
-        } else if (type == 2) {
-            return parse_operator_acc(std::numeric_limits<int64_t>::max(), [](int64_t acc, int64_t v) { return std::min(acc, v); });
-        } else if (type == 3) {
-            return parse_operator_acc(std::numeric_limits<int64_t>::min(), [](int64_t acc, int64_t v) { return std::max(acc, v); });
-        } else if (type == 5) {
-            return parse_operator_pair([](int64_t left, int64_t right) { return left > right; });
-        } else if (type == 6) {
-            return parse_operator_pair([](int64_t left, int64_t right) { return left < right; });
-        } else if (type == 7) {
-            return parse_operator_pair([](int64_t left, int64_t right) { return left == right; });
+    // Same as evaluate(), with the work split across the pool: the tree is cut into
+    // subtrees of at most a grain's worth of packets, each evaluated as its own task, and
+    // the packets above the cut are finished afterwards on this thread. There are about
+    // sixteen tasks per worker, so the workers pulling from the queue keep busy however
+    // lopsided the tree is.
+    std::vector<int64_t> evaluate_parallel(Utils::ThreadPool &pool) const {
+        const int32_t n = static_cast<int32_t>(packets.size());
+        const int32_t grain = std::max<int32_t>(n / (16 * pool.size()), MIN_TASK_PACKETS);
+        if (pool.size() == 1 || n <= 2 * grain) {
+            return evaluate();
         }
-        abort();
+        UTILS_TRACE_SCOPE("PacketIndex::evaluate_parallel", "packets", n);
+        std::vector<int64_t> values(n);
+        std::vector<std::future<void>> tasks;
+        std::vector<int32_t> above;
+        std::vector<int32_t> pending{0};
+        while (!pending.empty()) {
+            const int32_t i = pending.back();
+            pending.pop_back();
+            const int32_t end = packets[i].end;
+            if (end - i <= grain) {
+                tasks.push_back(pool.submit([this, i, end, &values]() {
+                    UTILS_TRACE_SCOPE("evaluate_subtree", "packets", end - i);
+                    evaluate_range(i, end, values.data());
+                }));
+                continue;
+            }
+            above.push_back(i);
+            for (int32_t c = i + 1; c < end; c = packets[c].end) {
+                pending.push_back(c);
+            }
+        }
+        for (auto &task : tasks) {
+            task.get();
+        }
+        // every packet comes after its parent in `above`
+        for (auto it = above.rbegin(); it != above.rend(); ++it) {
+            values[*it] = evaluate_node(*it, values.data());
+        }
+        return values;
+    }
+
+    static constexpr int32_t MIN_TASK_PACKETS = 1 << 14;
+};
+
+// Incremental decoder for hex text arriving in arbitrary chunks. All parse state is
+// explicit: at most 64 bits not yet consumed, the field being read and a stack of open
+// operators with their running values, so memory grows only with nesting depth, never
+// with the length of the feed. Every field is at most 15 bits, so it is consumed as
+// soon as enough hex digits have arrived.
+//
+// Each whitespace-separated run of hex is one transmission holding one top-level
+// packet; on_packet gets that packet's version sum and value as soon as its last bit
+// is in, and the rest of the run is padding.
+struct StreamDecoder {
+    enum class Field { Header, LiteralGroup, LengthType, Count, Length, Padding };
+
+    struct Open {
+        int type;
+        bool by_length;
+        int64_t limit; // end bit for length type 0, subpacket count for type 1
+        int64_t child_count;
+        int64_t acc;   // running fold, or the left operand of a comparison
+    };
+
+    std::function<void(int64_t version_sum, int64_t value)> on_packet;
+
+    uint64_t bits = 0; // unconsumed bits, left-aligned
+    int bit_count = 0;
+    int64_t position = 0; // bits consumed from the current transmission
+    Field field = Field::Header;
+    int type = 0;
+    int64_t literal = 0;
+    int64_t version_sum = 0;
+    std::vector<Open> open;
+
+    static StreamDecoder make(std::function<void(int64_t, int64_t)> on_packet) {
+        StreamDecoder rv;
+        rv.on_packet = std::move(on_packet);
+        return rv;
     }
 
-    int64_t parse_operator_acc(int64_t init, auto acc) {
-        int64_t value = init;
-        parse_multi([&](int64_t v) { value = acc(value, v); });
-        return value;
+    void feed(std::string_view chunk) {
+        std::size_t i = 0;
+        while (i < chunk.size()) {
+            if (Utils::is_space_byte(chunk[i])) {
+                end_transmission();
+                i = Utils::find_byte_class<Utils::ByteClass::NonSpace>(chunk, i);
+                continue;
+            }
+            const std::size_t end = Utils::find_byte_class<Utils::ByteClass::Space>(chunk, i);
+            push_hex(chunk.substr(i, end - i));
+            i = end;
+        }
     }
 
-    int64_t parse_operator_pair(auto fn) {
-        int current_index = 0;
-        int64_t left, right;
-        parse_multi([&](int64_t v) {
-            if (current_index == 0) {
-                left = v;
-            } else if (current_index == 1) {
-                right = v;
-            } else {
+    // End of the feed; the same as a trailing separator.
+    void finish() {
+        end_transmission();
+    }
+
+    void push_hex(std::string_view hex) {
+        const HexDecoder decode_hex = hex_decoder();
+        std::array<uint64_t, SCRATCH_WORDS> scratch;
+        for (std::size_t begin = 0; begin < hex.size(); begin += 16 * SCRATCH_WORDS) {
+            const std::string_view block = hex.substr(begin, 16 * SCRATCH_WORDS);
+            if (!decode_hex(block, scratch.data())) {
+                std::cerr << "ERROR: Transmission has a character that isn't a hex digit\n";
                 abort();
             }
-            ++current_index;
-        });
-        int64_t value = fn(left, right);
-        return value;
+            const std::size_t full_words = block.size() / 16;
+            for (std::size_t w = 0; w < full_words; ++w) {
+                push_bits(scratch[w], 64);
+            }
+            if (block.size() % 16 != 0) {
+                push_bits(scratch[full_words], static_cast<int>(block.size() % 16) * 4);
+            }
+        }
     }
 
-    void parse_multi(auto fn) {
-        int length_type = read(1);
-        if (length_type) {
-            int subpacket_count = read(11);
-            for (int i = 0; i < subpacket_count; ++i) {
-                int64_t value = parse_packet();
-                fn(value);
-            }
-        } else {
-            int total_sublength = read(15);
-            auto start_pos = getpos();
-            while (getpos() - start_pos < total_sublength) {
-                int64_t value = parse_packet();
-                fn(value);
+    // Appends the top `count` bits of word and consumes every field they complete.
+    void push_bits(uint64_t word, int count) {
+        while (count > 0) {
+            const int k = std::min(count, 64 - bit_count);
+            bits |= (word >> (64 - k)) << (64 - bit_count - k);
+            word = k < 64 ? word << k : 0;
+            count -= k;
+            bit_count += k;
+            while (step()) {
             }
         }
     }
 
-    int64_t parse_literal() {
-        int64_t v = 0;
-        while (true) {
-            int x = read(5);
-            v = (v << 4) | (x & 0xf);
+    uint64_t take(int n) {
+        const uint64_t rv = bits >> (64 - n);
+        bits <<= n;
+        bit_count -= n;
+        position += n;
+        return rv;
+    }
+
+    // Consumes one field if all of its bits are buffered.
+    bool step() {
+        switch (field) {
+        case Field::Header:
+            if (bit_count < 6) {
+                return false;
+            }
+            version_sum += static_cast<int64_t>(take(3));
+            type = static_cast<int>(take(3));
+            literal = 0;
+            field = type == 4 ? Field::LiteralGroup : Field::LengthType;
+            return true;
+        case Field::LiteralGroup: {
+            if (bit_count < 5) {
+                return false;
+            }
+            const uint64_t x = take(5);
+            literal = (literal << 4) | static_cast<int64_t>(x & 0xf);
             if (!(x & 0x10)) {
-                break;
+                complete(literal);
+            }
+            return true;
+        }
+        case Field::LengthType:
+            if (bit_count < 1) {
+                return false;
+            }
+            field = take(1) ? Field::Count : Field::Length;
+            return true;
+        case Field::Count:
+            if (bit_count < 11) {
+                return false;
+            }
+            open.push_back({type, false, static_cast<int64_t>(take(11)), 0, operator_init(type)});
+            close_if_empty();
+            return true;
+        case Field::Length: {
+            if (bit_count < 15) {
+                return false;
             }
+            const int64_t length = static_cast<int64_t>(take(15));
+            open.push_back({type, true, position + length, 0, operator_init(type)});
+            close_if_empty();
+            return true;
+        }
+        case Field::Padding:
+            bits = 0;
+            bit_count = 0;
+            return false;
+        }
+        return false;
+    }
+
+    bool finished(const Open &op) const {
+        if (op.by_length && position > op.limit) {
+            std::cerr << "ERROR: Subpackets overrun their parent's length at bit " << position << "\n";
+            abort();
+        }
+        return op.by_length ? position == op.limit : op.child_count == op.limit;
+    }
+
+    int64_t close(const Open &op) const {
+        if (op.type > 4 && op.child_count != 2) {
+            std::cerr << "ERROR: Comparison packet ending at bit " << position << " has " << op.child_count
+                      << " subpackets\n";
+            abort();
+        }
+        return op.acc;
+    }
+
+    void close_if_empty() {
+        if (finished(open.back())) {
+            const int64_t value = close(open.back());
+            open.pop_back();
+            complete(value);
+        } else {
+            field = Field::Header;
+        }
+    }
+
+    // A packet just ended with `value`: hand it to its parent, closing every operator
+    // it was the last subpacket of, or report it if it was the top-level one.
+    void complete(int64_t value) {
+        while (!open.empty()) {
+            Open &parent = open.back();
+            if (parent.type < 4) {
+                parent.acc = operator_fold(parent.type, parent.acc, value);
+            } else if (parent.child_count == 0) {
+                parent.acc = value;
+            } else if (parent.child_count == 1) {
+                parent.acc = operator_compare(parent.type, parent.acc, value);
+            }
+            ++parent.child_count;
+            if (!finished(parent)) {
+                field = Field::Header;
+                return;
+            }
+            value = close(parent);
+            open.pop_back();
+        }
+        on_packet(version_sum, value);
+        field = Field::Padding;
+    }
+
+    void end_transmission() {
+        const bool idle = field == Field::Header && position == 0;
+        if (!idle && field != Field::Padding) {
+            std::cerr << "ERROR: Transmission ends in the middle of a packet\n";
+            abort();
+        }
+        bits = 0;
+        bit_count = 0;
+        position = 0;
+        version_sum = 0;
+        field = Field::Header;
+    }
+
+    static const std::size_t SCRATCH_WORDS = 64;
+};
+
+auto solve1 = [](const Utils::InputView &is, std::ostream &os) {
+    auto index = PacketIndex::build(read_input(is));
+    os << index.version_sum();
+};
+
+auto solve2 = [](const Utils::InputView &is, std::ostream &os) {
+    auto index = PacketIndex::build(read_input(is));
+    os << index.evaluate_parallel(Utils::ThreadPool::shared())[0];
+};
+
+// Buffers one worker reuses for every transmission of a batch it evaluates.
+struct BatchScratch {
+    std::vector<uint64_t> words;
+    PacketIndex index;
+    std::vector<int64_t> values;
+
+    int64_t solve(std::string_view hex, bool value) {
+        decode_into(hex, words);
+        index.parse(words);
+        if (!value) {
+            return index.version_sum();
         }
-        return v;
+        index.evaluate_into(values);
+        return values[0];
+    }
+};
+
+// Results of every whitespace-separated transmission in the input, in input order.
+// Transmissions are spread over the shared pool; each worker keeps its own scratch
+// buffers for the life of the thread, so a batch of short transmissions allocates
+// almost nothing after warming up.
+std::vector<int64_t> solve_batch(const Utils::InputView &is, bool values) {
+    std::vector<std::string_view> transmissions;
+    auto tokenizer = is.tokenizer();
+    while (auto hex = tokenizer.next_word()) {
+        transmissions.push_back(*hex);
+    }
+    std::vector<int64_t> rv(transmissions.size());
+    Utils::ThreadPool::shared().parallel_for(0, std::ssize(transmissions), [&](int64_t i) {
+        thread_local BatchScratch scratch;
+        rv[i] = scratch.solve(transmissions[i], values);
+    });
+    return rv;
+}
+
+void print_batch(const std::vector<int64_t> &results, std::ostream &os) {
+    std::string sep;
+    for (int64_t r : results) {
+        os << sep << r;
+        sep = "\n";
     }
+}
+
+auto solve1_batch = [](const Utils::InputView &is, std::ostream &os) {
+    print_batch(solve_batch(is, false), os);
 };
 
-auto solve1 = [](std::istringstream &is, std::ostream &os) {
-    auto input = read_input(is);
-    auto parser = Parser::make(input);
-    parser.parse_packet();
-    os << parser.version_sum;
+auto solve2_batch = [](const Utils::InputView &is, std::ostream &os) {
+    print_batch(solve_batch(is, true), os);
 };
 
-auto solve2 = [](std::istringstream &is, std::ostream &os) {
-    auto input = read_input(is);
-    auto parser = Parser::make(input);
-    os << parser.parse_packet();
+// Order-sensitive digest of a batch's part 2 results, for benching inputs whose full
+// output is too long to spell out as the expected answer.
+auto solve2_batch_digest = [](const Utils::InputView &is, std::ostream &os) {
+    uint64_t digest = 0;
+    for (int64_t r : solve_batch(is, true)) {
+        digest = digest * 1000003 + static_cast<uint64_t>(r);
+    }
+    os << digest;
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day16"};
+int64_t count_transmissions(const Utils::InputView &is) {
+    int64_t rv = 0;
+    auto tokenizer = is.tokenizer();
+    while (tokenizer.next_word()) {
+        ++rv;
+    }
+    return rv;
+}
 
-        tester.test("part1", "in-2", "6", solve1);
-        tester.test("part1", "in-1", "9", solve1);
-        tester.test("part1", "in0", "14", solve1);
-        tester.test("part1", "in1", "16", solve1);
-        tester.test("part1", "in2", "12", solve1);
-        tester.test("part1", "in3", "23", solve1);
-        tester.test("part1", "in4", "31", solve1);
-        tester.test("part1", "in5", "974", solve1);
+const std::size_t STREAM_CHUNK_BYTES = 1000;
 
-        tester.test("part2", "in6", "3", solve2);
-        tester.test("part2", "in7", "54", solve2);
-        tester.test("part2", "in8", "7", solve2);
-        tester.test("part2", "in9", "9", solve2);
-        tester.test("part2", "in10", "1", solve2);
-        tester.test("part2", "in11", "0", solve2);
-        tester.test("part2", "in13", "1", solve2);
-        tester.test("part2", "in5", "180616437720", solve2);
+// Feeds the input through StreamDecoder a bounded chunk at a time, the way a continuous
+// feed would arrive, and prints one result per transmission.
+void solve_stream(const Utils::InputView &is, std::ostream &os, bool values) {
+    std::string sep;
+    auto decoder = StreamDecoder::make([&](int64_t version_sum, int64_t value) {
+        os << sep << (values ? value : version_sum);
+        sep = "\n";
+    });
+    const std::string_view data = is.str();
+    for (std::size_t begin = 0; begin < data.size(); begin += STREAM_CHUNK_BYTES) {
+        decoder.feed(data.substr(begin, STREAM_CHUNK_BYTES));
     }
+    decoder.finish();
+}
+
+auto solve1_stream = [](const Utils::InputView &is, std::ostream &os) {
+    solve_stream(is, os, false);
+};
+
+auto solve2_stream = [](const Utils::InputView &is, std::ostream &os) {
+    solve_stream(is, os, true);
+};
 
-    Utils::bench("day16", "part2", "in5", "180616437720", 10000, solve2);
+// Appends a random packet tree of exactly n packets to `bits` ('0'/'1' chars). Products
+// only ever multiply two small literals, so part 2 stays well inside int64.
+void generate_packet(int64_t n, std::mt19937_64 &rng, std::string &bits) {
+    auto put = [&bits](uint64_t v, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            bits.push_back(static_cast<char>('0' + ((v >> i) & 1)));
+        }
+    };
+    put(rng() % 8, 3);
+    if (n == 1) {
+        put(4, 3);
+        uint64_t value = rng() % (1 << 20);
+        int groups = 1;
+        while (groups < 16 && (value >> (4 * groups)) != 0) {
+            ++groups;
+        }
+        for (int g = groups - 1; g >= 0; --g) {
+            put((uint64_t{g > 0} << 4) | ((value >> (4 * g)) & 0xf), 5);
+        }
+        return;
+    }
+
+    int type;
+    std::vector<int64_t> sizes;
+    if (n == 3 && rng() % 2 == 0) {
+        type = std::array{1, 5, 6, 7}[rng() % 4];
+        sizes = {1, 1};
+    } else {
+        const bool pair = n >= 3 && rng() % 8 == 0;
+        type = pair ? 5 + static_cast<int>(rng() % 3) : std::array{0, 2, 3}[rng() % 3];
+        const int64_t k = pair ? 2 : 1 + static_cast<int64_t>(rng() % std::min<uint64_t>(n - 1, 8));
+        // k positive sizes summing to n - 1: random cuts through the n - 1 - k spare packets
+        std::vector<int64_t> cuts{0, n - 1 - k};
+        for (int64_t i = 0; i < k - 1; ++i) {
+            cuts.push_back(static_cast<int64_t>(rng() % static_cast<uint64_t>(n - k)));
+        }
+        std::sort(cuts.begin(), cuts.end());
+        for (int64_t i = 0; i < k; ++i) {
+            sizes.push_back(cuts[i + 1] - cuts[i] + 1);
+        }
+    }
+    put(type, 3);
+
+    // Under ~1000 packets the children surely fit a 15-bit length, which gets patched in
+    // once they're written; bigger subtrees give their packet count instead.
+    if (n <= 1000 && rng() % 2 == 0) {
+        put(0, 1);
+        const std::size_t length_at = bits.size();
+        put(0, 15);
+        for (int64_t size : sizes) {
+            generate_packet(size, rng, bits);
+        }
+        const std::size_t length = bits.size() - length_at - 15;
+        for (int i = 0; i < 15; ++i) {
+            bits[length_at + i] = static_cast<char>('0' + ((length >> (14 - i)) & 1));
+        }
+    } else {
+        put(1, 1);
+        put(sizes.size(), 11);
+        for (int64_t size : sizes) {
+            generate_packet(size, rng, bits);
+        }
+    }
+}
+
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    std::string bits;
+    generate_packet(std::max<int64_t>(n, 1), rng, bits);
+    while (bits.size() % 4 != 0) {
+        bits.push_back('0');
+    }
+    std::string hex;
+    hex.reserve(bits.size() / 4 + 1);
+    for (std::size_t i = 0; i < bits.size(); i += 4) {
+        int v = (bits[i] - '0') << 3 | (bits[i + 1] - '0') << 2 | (bits[i + 2] - '0') << 1 | (bits[i + 3] - '0');
+        hex.push_back("0123456789ABCDEF"[v]);
+    }
+    hex.push_back('\n');
+    return hex;
 }
+
+const Utils::Registration registration{"Day16A", "day16", [](Utils::DayEntry &day) {
+    day.test("part1", "in-2", "6", solve1);
+    day.test("part1", "in-1", "9", solve1);
+    day.test("part1", "in0", "14", solve1);
+    day.test("part1", "in1", "16", solve1);
+    day.test("part1", "in2", "12", solve1);
+    day.test("part1", "in3", "23", solve1);
+    day.test("part1", "in4", "31", solve1);
+    day.test("part1", "in5", "974", solve1);
+
+    day.test("part2", "in6", "3", solve2);
+    day.test("part2", "in7", "54", solve2);
+    day.test("part2", "in8", "7", solve2);
+    day.test("part2", "in9", "9", solve2);
+    day.test("part2", "in10", "1", solve2);
+    day.test("part2", "in11", "0", solve2);
+    day.test("part2", "in13", "1", solve2);
+    day.test("part2", "in5", "180616437720", solve2);
+
+    day.test("part1 stream", "in3", "23", solve1_stream);
+    day.test("part1 stream", "in5", "974", solve1_stream);
+    day.test("part2 stream", "in7", "54", solve2_stream);
+    day.test("part2 stream", "in11", "0", solve2_stream);
+    day.test("part2 stream", "in5", "180616437720", solve2_stream);
+
+    day.test("part1 batch", "in14", "6\n9\n14\n16\n12\n23\n31\n974\n14\n8\n15\n11\n13\n19\n16\n20", solve1_batch);
+    day.test("part2 batch", "in14", "2021\n1\n3\n15\n46\n46\n54\n180616437720\n3\n54\n7\n9\n1\n0\n0\n1", solve2_batch);
+    day.test("part2 batch digest", "in15", "3865026511574637360", solve2_batch_digest);
+
+    day.bench("part1", "in5", "974", solve1);
+    day.bench("part2", "in5", "180616437720", solve2);
+    day.bench("part2 stream", "in5", "180616437720", solve2_stream);
+    day.bench("part2 batch digest", "in15", "3865026511574637360", solve2_batch_digest,
+              {"transmissions", count_transmissions});
+
+    day.generate("packets", generate);
+    day.scaling("part1", {1000, 10000, 100000, 1000000, 4000000}, solve1);
+    day.scaling("part2", {1000, 10000, 100000, 1000000, 4000000}, solve2);
+    day.scaling("part2 stream", {1000, 10000, 100000, 1000000, 4000000}, solve2_stream);
+}};
 } // namespace Day16A
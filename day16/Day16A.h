@@ -1,7 +0,0 @@
-#pragma once
-
-namespace Day16A {
-
-void main();
-
-}
@@ -1,49 +1,20 @@
-#include "Utils.h"
-#include <map>
-#include <set>
+#include "CpuFeatures.h"
+#include "Registry.h"
+#include <bit>
+#include <cmath>
 
 namespace Day17A {
 
-struct Reader {
-    const std::string &s;
-    int pos = 0;
-
-    static bool is_relevant(char c) {
-        return ('0' <= c && c <= '9') || c == '-';
-    }
-
-    int read_int() {
-        bool is_negative = false;
-        while (!is_relevant(s[pos])) {
-            ++pos;
-        }
-        if (s[pos] == '-') {
-            is_negative = true;
-            ++pos;
-        }
-        int value = 0;
-        while (is_relevant(s[pos])) {
-            value = value * 10 + (s[pos] - '0');
-            ++pos;
-        }
-        if (is_negative) {
-            value = -value;
-        }
-        return value;
-    }
-};
-
-std::tuple<int, int, int, int> read_input(std::istringstream &is) {
-    const std::string &buf = is.str();
-    Reader reader{buf};
-    int llx = reader.read_int();
-    int urx = reader.read_int();
-    int lly = reader.read_int();
-    int ury = reader.read_int();
+std::tuple<int, int, int, int> read_input(const Utils::InputView &input) {
+    auto tokenizer = input.tokenizer();
+    int llx = static_cast<int>(tokenizer.expect_int());
+    int urx = static_cast<int>(tokenizer.expect_int());
+    int lly = static_cast<int>(tokenizer.expect_int());
+    int ury = static_cast<int>(tokenizer.expect_int());
     return {llx, urx, lly, ury};
 }
 
-auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
     const auto &[llx, urx, lly, ury] = read_input(is);
     int initial_y = -lly - 1;
     int max_y = initial_y * (initial_y + 1) / 2;
@@ -52,7 +23,7 @@ auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
 
 bool hits_target(int llx, int urx, int lly, int ury, int ivx, int ivy) {
     int x = 0, y = 0, vx = ivx, vy = ivy;
-    if (ivx * (ivx + 1) / 2 < llx) {
+    if (int64_t{ivx} * (ivx + 1) / 2 < llx) {
         return false;
     }
     while (true) {
@@ -74,104 +45,307 @@ bool hits_target(int llx, int urx, int lly, int ury, int ivx, int ivy) {
     }
 }
 
-void for_each_hit_x(int llx, int urx, int ivx, auto fn) {
-    int x = 0, vx = ivx;
-    if (ivx * (ivx + 1) / 2 < llx) {
-        return;
+// Step intervals, in closed form, during which a probe is inside the target's x or y
+// range. x(t) = t*vx - t(t-1)/2 until vx runs out and y(t) = t*vy - t(t-1)/2, so each
+// crossing is a root of a quadratic; the floating point estimate is nudged to the exact
+// integer step. The target is right of and below the launch point (llx > 0, ury < 0).
+const int64_t NEVER = std::numeric_limits<int64_t>::max();
+
+int64_t pos_after(int64_t v, int64_t t) {
+    return t * v - t * (t - 1) / 2;
+}
+
+// First step at which x >= target, for an x velocity whose final x reaches target.
+int64_t first_step_x_at_least(int64_t vx, int64_t target) {
+    const double b = 2.0 * static_cast<double>(vx) + 1;
+    int64_t t = static_cast<int64_t>(std::ceil((b - std::sqrt(b * b - 8.0 * static_cast<double>(target))) / 2));
+    t = std::clamp<int64_t>(t, 0, vx);
+    while (t > 0 && pos_after(vx, t - 1) >= target) {
+        --t;
     }
-    for (int step = 0; step < 300; ++step) {
-        if (x > urx) {
-            return;
-        }
-        if (llx <= x && x <= urx) {
-            fn(step);
-        }
-        x += vx;
-        if (vx > 0) {
-            vx -= 1;
-        }
+    while (pos_after(vx, t) < target) {
+        ++t;
     }
+    return t;
 }
 
-void for_each_hit_y(int lly, int ury, int ivy, auto fn) {
-    int y = 0, vy = ivy;
-    for (int step = 0;; ++step) {
-        if (y < lly) {
-            return;
+// First step at which y <= target, for target < 0.
+int64_t first_step_y_at_most(int64_t vy, int64_t target) {
+    const double b = 2.0 * static_cast<double>(vy) + 1;
+    int64_t t = static_cast<int64_t>(std::ceil((b + std::sqrt(b * b - 8.0 * static_cast<double>(target))) / 2));
+    t = std::max<int64_t>(t, 0);
+    while (t > 0 && pos_after(vy, t - 1) <= target) {
+        --t;
+    }
+    while (pos_after(vy, t) > target) {
+        ++t;
+    }
+    return t;
+}
+
+struct StepInterval {
+    int64_t first, last; // last is NEVER when the probe stays in range for good
+
+    bool empty() const {
+        return first > last;
+    }
+};
+
+StepInterval x_steps(int64_t llx, int64_t urx, int64_t vx) {
+    const int64_t final_x = pos_after(vx, vx);
+    if (final_x < llx) {
+        return {NEVER, 0};
+    }
+    const int64_t first = first_step_x_at_least(vx, llx);
+    const int64_t last = final_x <= urx ? NEVER : first_step_x_at_least(vx, urx + 1) - 1;
+    return {first, last};
+}
+
+StepInterval y_steps(int64_t lly, int64_t ury, int64_t vy) {
+    return {first_step_y_at_most(vy, ury), first_step_y_at_most(vy, lly - 1) - 1};
+}
+
+struct Target {
+    int64_t llx, urx, lly, ury;
+};
+
+struct TargetResult {
+    int64_t max_height = 0; // highest apex among hitting launches, 0 when nothing hits
+    int64_t hit_count = 0;
+};
+
+TargetResult evaluate_target(const Target &target) {
+    const auto &[llx, urx, lly, ury] = target;
+
+    // A pair hits iff its x and y intervals overlap. Both ends of the x interval only
+    // move earlier as vx grows and both ends of the y interval only move later as vy
+    // grows, so walking vy upwards, two pointers sweep vx downwards once each:
+    //   #{vx : first_x <= last_y and last_x >= first_y}
+    //     = #{vx : first_x <= last_y} - #{vx : last_x < first_y}
+    // counting only vx whose interval isn't empty (for those the second set is inside
+    // the first). No step cap and no storage beyond a few counters.
+    int64_t reached_vx = urx, reached_count = 0;
+    int64_t left_vx = urx, left_count = 0;
+    TargetResult rv;
+    for (int64_t vy = lly; vy <= -lly - 1; ++vy) {
+        const StepInterval y = y_steps(lly, ury, vy);
+        if (y.empty()) {
+            continue;
         }
-        if (lly <= y && y <= ury) {
-            fn(step);
+        for (; reached_vx >= 1; --reached_vx) {
+            const StepInterval x = x_steps(llx, urx, reached_vx);
+            if (x.first > y.last) {
+                break;
+            }
+            reached_count += !x.empty();
+        }
+        for (; left_vx >= 1; --left_vx) {
+            const StepInterval x = x_steps(llx, urx, left_vx);
+            if (x.last >= y.first) {
+                break;
+            }
+            left_count += !x.empty();
+        }
+        const int64_t hits = reached_count - left_count;
+        if (hits > 0) {
+            rv.hit_count += hits;
+            rv.max_height = vy > 0 ? vy * (vy + 1) / 2 : 0;
         }
-        y += vy;
-        vy -= 1;
     }
+    return rv;
 }
 
-auto solve2 = [](std::istringstream &is, std::ostringstream &os) {
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
     const auto &[llx, urx, lly, ury] = read_input(is);
-    int min_x = 1;
-    int max_x = urx;
-    int min_y = lly;
-    int initial_y = -lly - 1;
-    int max_y = initial_y * (initial_y + 1) / 2;
+    os << evaluate_target({llx, urx, lly, ury}).hit_count;
+};
 
-    std::map<int, std::vector<int>> feasible_x, feasible_y;
 
-    for (int ivx = min_x; ivx <= max_x; ++ivx) {
-        for_each_hit_x(llx, urx, ivx, [&](int step) {
-            feasible_x[step].push_back(ivx);
-        });
+// Brute force: simulates every launch in the velocity grid step by step. It makes no
+// assumption beyond the target being right of and below the launch point, so it is the
+// reference the closed-form engine is checked against. The AVX2 kernel moves sixteen
+// launches with the same vy and consecutive vx in lock step; since they share y they
+// mostly finish together, and each lane drops out on its own once it hits or overshoots.
+// Lanes are 32-bit, which holds every position for targets up to 65535 deep and ending
+// short of x = 2^30.
+int64_t slowest_reaching_vx(int64_t llx) {
+    int64_t vx = static_cast<int64_t>(std::sqrt(2.0 * static_cast<double>(llx)));
+    while (vx > 0 && vx * (vx - 1) / 2 >= llx) {
+        --vx;
     }
-    for (int ivy = min_y; ivy <= max_y; ++ivy) {
-        for_each_hit_y(lly, ury, ivy, [&](int step) {
-            feasible_y[step].push_back(ivy);
-        });
+    while (vx * (vx + 1) / 2 < llx) {
+        ++vx;
     }
+    return vx;
+}
 
-    std::set<std::tuple<int, int>> feasible_pairs;
-    for (const auto &[step, ivxs] : feasible_x) {
-        const auto &ivys = feasible_y[step];
-        for (int ivx : ivxs) {
-            for (int ivy : ivys) {
-                feasible_pairs.insert({ivx, ivy});
-            }
+int64_t count_hits_brute_scalar(const Target &target) {
+    const auto &[llx, urx, lly, ury] = target;
+    int64_t rv = 0;
+    for (int64_t vy = lly; vy <= -lly - 1; ++vy) {
+        for (int64_t vx = slowest_reaching_vx(llx); vx <= urx; ++vx) {
+            rv += hits_target(static_cast<int>(llx), static_cast<int>(urx), static_cast<int>(lly), static_cast<int>(ury),
+                              static_cast<int>(vx), static_cast<int>(vy));
         }
     }
+    return rv;
+}
 
-    os << std::size(feasible_pairs);
+#ifdef UTILS_X86
+// The comparisons are all strict: a <= x  <=>  x > a - 1.
+struct LaneBounds {
+    __m256i llx_1, urx, lly, ury_1;
+};
+
+// One step of eight launches that share y: moves x, then retires the lanes that hit,
+// went past the target or fell below it.
+UTILS_TARGET("avx2")
+inline void advance_lanes(const LaneBounds &b, __m256i &x, __m256i &vx, __m256i &hit, __m256i &active, __m256i y) {
+    const __m256i zero = _mm256_setzero_si256();
+    x = _mm256_add_epi32(x, vx);
+    vx = _mm256_max_epi32(_mm256_sub_epi32(vx, _mm256_set1_epi32(1)), zero);
+    const __m256i past_x = _mm256_cmpgt_epi32(x, b.urx);
+    const __m256i below = _mm256_cmpgt_epi32(b.lly, y);
+    const __m256i out = _mm256_or_si256(past_x, below);
+    const __m256i inside =
+        _mm256_andnot_si256(out, _mm256_and_si256(_mm256_cmpgt_epi32(x, b.llx_1), _mm256_cmpgt_epi32(b.ury_1, y)));
+    hit = _mm256_or_si256(hit, _mm256_and_si256(inside, active));
+    active = _mm256_andnot_si256(_mm256_or_si256(inside, out), active);
+}
 
-    //int feasible_count = 0;
-    //for (int ivx : feasible_x) {
-    //    for (int ivy : feasible_y) {
-    //        if (hits_target(llx, urx, lly, ury, ivx, ivy)) {
-    //            ++feasible_count;
-    //        }
-    //    }
-    //}
+UTILS_TARGET("avx2")
+int64_t count_hits_brute_avx2(const Target &target) {
+    const auto &[llx, urx, lly, ury] = target;
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i urx_1 = _mm256_set1_epi32(static_cast<int32_t>(urx + 1));
+    const LaneBounds bounds{
+        _mm256_set1_epi32(static_cast<int32_t>(llx - 1)),
+        _mm256_set1_epi32(static_cast<int32_t>(urx)),
+        _mm256_set1_epi32(static_cast<int32_t>(lly)),
+        _mm256_set1_epi32(static_cast<int32_t>(ury + 1)),
+    };
 
-    //int feasible_count = 0;
-    //for (int ivx = min_x; ivx <= max_x; ++ivx) {
-    //    for (int ivy = min_y; ivy <= max_y; ++ivy) {
-    //        if (hits_target(llx, urx, lly, ury, ivx, ivy)) {
-    //            ++feasible_count;
-    //        }
-    //    }
-    //}
+    int64_t rv = 0;
+    for (int64_t ivy = lly; ivy <= -lly - 1; ++ivy) {
+        // two groups per pass, sixteen launches, to keep more independent work in flight
+        for (int64_t ivx = slowest_reaching_vx(llx); ivx <= urx; ivx += 16) {
+            __m256i vx0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(ivx)), lane);
+            __m256i vx1 = _mm256_add_epi32(vx0, _mm256_set1_epi32(8));
+            __m256i x0 = zero, x1 = zero, hit0 = zero, hit1 = zero;
+            __m256i active0 = _mm256_cmpgt_epi32(urx_1, vx0), active1 = _mm256_cmpgt_epi32(urx_1, vx1);
+            __m256i y = zero, vy = _mm256_set1_epi32(static_cast<int32_t>(ivy));
+            while (!_mm256_testz_si256(_mm256_or_si256(active0, active1), _mm256_or_si256(active0, active1))) {
+                y = _mm256_add_epi32(y, vy);
+                vy = _mm256_sub_epi32(vy, _mm256_set1_epi32(1));
+                advance_lanes(bounds, x0, vx0, hit0, active0, y);
+                advance_lanes(bounds, x1, vx1, hit1, active1, y);
+            }
+            rv += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit0))));
+            rv += std::popcount(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit1))));
+        }
+    }
+    return rv;
+}
+#endif
 
-    //os << feasible_count;
+int64_t count_hits_brute(const Target &target) {
+    if (-target.lly > 65535 || target.urx >= (1 << 30)) {
+        std::cerr << "ERROR: Target too large to simulate\n";
+        abort();
+    }
+#ifdef UTILS_X86
+    if (Utils::CpuFeatures::get().avx2) {
+        return count_hits_brute_avx2(target);
+    }
+#endif
+    return count_hits_brute_scalar(target);
+}
+
+auto solve2_brute = [](const Utils::InputView &is, std::ostringstream &os) {
+    const auto &[llx, urx, lly, ury] = read_input(is);
+    os << count_hits_brute({llx, urx, lly, ury});
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day17"};
+// Every "target area" in the input, in order.
+std::vector<Target> read_targets(const Utils::InputView &input) {
+    std::vector<Target> rv;
+    auto tokenizer = input.tokenizer();
+    while (auto llx = tokenizer.next_int()) {
+        const int64_t urx = tokenizer.expect_int();
+        const int64_t lly = tokenizer.expect_int();
+        const int64_t ury = tokenizer.expect_int();
+        rv.push_back({*llx, urx, lly, ury});
+    }
+    return rv;
+}
 
-        tester.test("part1", "in1", "45", solve1);
-        tester.test("part1", "in2", "7750", solve1);
+// Results for many targets at once, spread over the pool. evaluate_target keeps no
+// per-velocity tables (every interval is closed form), so targets share nothing but the
+// workers and each one costs O(x range + y range) with no allocation.
+std::vector<TargetResult> evaluate_targets(const std::vector<Target> &targets, Utils::ThreadPool &pool) {
+    std::vector<TargetResult> rv(targets.size());
+    pool.parallel_for(0, std::ssize(targets), [&](int64_t i) {
+        rv[i] = evaluate_target(targets[i]);
+    });
+    return rv;
+}
 
-        tester.test("part2", "in1", "112", solve2);
-        tester.test("part2", "in2", "4120", solve2);
+// One "max_height hit_count" line per target.
+auto solve_batch = [](const Utils::InputView &is, std::ostringstream &os) {
+    std::string sep;
+    for (const auto &result : evaluate_targets(read_targets(is), Utils::ThreadPool::shared())) {
+        os << sep << result.max_height << " " << result.hit_count;
+        sep = "\n";
     }
+};
 
-    Utils::bench("day17", "part2", "in2", "4120", 100, solve2);
+// Order-sensitive digest of solve_batch's results, for batches too long to spell out.
+auto solve_batch_digest = [](const Utils::InputView &is, std::ostringstream &os) {
+    uint64_t digest = 0;
+    for (const auto &result : evaluate_targets(read_targets(is), Utils::ThreadPool::shared())) {
+        digest = digest * 1000003 + static_cast<uint64_t>(result.max_height);
+        digest = digest * 1000003 + static_cast<uint64_t>(result.hit_count);
+    }
+    os << digest;
+};
+
+int64_t count_targets(const Utils::InputView &is) {
+    return std::ssize(read_targets(is));
+}
+
+// Target area whose coordinates are of order n, below and to the right of the probe.
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    n = std::max<int64_t>(n, 2);
+    const int64_t llx = n + static_cast<int64_t>(rng() % n);
+    const int64_t urx = llx + n / 2 + static_cast<int64_t>(rng() % (n / 2));
+    const int64_t lly = -2 * n - static_cast<int64_t>(rng() % n);
+    const int64_t ury = lly + n / 2 + static_cast<int64_t>(rng() % (n / 2));
+    std::ostringstream os;
+    os << "target area: x=" << llx << ".." << urx << ", y=" << lly << ".." << ury << "\n";
+    return os.str();
 }
+
+const Utils::Registration registration{"Day17A", "day17", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "45", solve1);
+    day.test("part1", "in2", "7750", solve1);
+
+    day.test("part2", "in1", "112", solve2);
+    day.test("part2", "in2", "4120", solve2);
+
+    day.test("part2 brute", "in1", "112", solve2_brute);
+    day.test("part2 brute", "in2", "4120", solve2_brute);
+
+    day.test("batch", "in3", "45 112\n7750 4120", solve_batch);
+    day.test("batch digest", "in4", "9110759549889599277", solve_batch_digest);
+
+    day.bench("part1", "in2", "7750", solve1);
+    day.bench("part2", "in2", "4120", solve2);
+    day.bench("part2 brute", "in2", "4120", solve2_brute);
+    day.bench("batch digest", "in4", "9110759549889599277", solve_batch_digest, {"targets", count_targets});
+
+    day.generate("coordinate scale", generate);
+    day.scaling("part2", {10, 100, 1000, 10000, 100000, 1000000, 10000000}, solve2);
+    day.scaling("part2 brute", {10, 30, 100, 300, 1000, 3000}, solve2_brute);
+}};
 } // namespace Day17A
\ No newline at end of file
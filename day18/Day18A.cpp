@@ -1,129 +1,151 @@
-#include "Utils.h"
+#include "Registry.h"
+#include <array>
+#include <atomic>
 #include <string_view>
 
 namespace Day18A {
 
-struct Number;
-
+// A snailfish number as its regular numbers in order, each with the depth of the pair
+// holding it. Reduced numbers nest at most four deep, so they hold at most 16 regular
+// numbers, and the sum of two holds at most 32 at depth five; explodes only ever bring
+// that count back down, and a split never leaves more than 17. So everything fits in
+// fixed arrays and reduction happens in place, with no heap allocation at all.
 struct Number {
-    std::vector<std::tuple<int, int>> data;
+    static const int CAPACITY = 32;
+
+    std::array<uint8_t, CAPACITY> depth;
+    std::array<uint8_t, CAPACITY> value;
+    int size = 0;
 
     static Number from_sv(const std::string_view &sv) {
-        std::vector<std::tuple<int, int>> data;
+        Number rv;
         int level = 0;
-        for (int i = 0; i < std::ssize(sv); ++i) {
-            char c = sv[i];
+        for (char c : sv) {
             if (c == '[') {
                 ++level;
             } else if (c == ']') {
                 --level;
             } else if ('0' <= c && c <= '9') {
-                data.push_back({level, c - '0'});
+                if (level > 4 || rv.size == CAPACITY / 2) {
+                    std::cerr << "ERROR: Snailfish number isn't reduced: " << sv << "\n";
+                    abort();
+                }
+                rv.depth[rv.size] = static_cast<uint8_t>(level);
+                rv.value[rv.size] = static_cast<uint8_t>(c - '0');
+                ++rv.size;
             }
         }
-        return Number{data};
+        return rv;
     }
 
-    std::optional<Number> reduce_nested() const {
-        for (int i = 0; i < std::ssize(data) - 1; ++i) {
-            const auto &[left_level, left_value] = data[i];
-            const auto &[right_level, right_value] = data[i + 1];
-            if (left_level == 5 && right_level == 5) {
-                std::vector<std::tuple<int, int>> new_data;
-                std::copy(data.begin(), data.begin() + i, std::back_inserter(new_data));
-                new_data.push_back({left_level - 1, 0});
-                std::copy(data.begin() + i + 2, data.end(), std::back_inserter(new_data));
-                if (i != 0) {
-                    auto &[lefter_level, lefter_value] = new_data[i - 1];
-                    lefter_value += left_value;
-                }
-                if (i + 2 < std::ssize(data)) {
-                    auto &[righter_level, righter_value] = new_data[i + 1];
-                    righter_value += right_value;
+    // Explodes every depth-five pair, left to right, in one compacting pass. Exploding
+    // never creates a new depth-five pair, so one pass clears them all.
+    void explode_all() {
+        int w = 0;
+        uint8_t carry = 0;
+        for (int r = 0; r < size; ++r, ++w) {
+            if (depth[r] == 5) {
+                if (w > 0) {
+                    value[w - 1] += value[r] + carry;
                 }
-                return Number{new_data};
+                carry = value[r + 1];
+                depth[w] = 4;
+                value[w] = 0;
+                ++r;
+            } else {
+                depth[w] = depth[r];
+                value[w] = value[r] + carry;
+                carry = 0;
             }
         }
-        return std::nullopt;
+        size = w;
     }
 
-    std::optional<Number> reduce_split() const {
-        for (int i = 0; i < std::ssize(data); ++i) {
-            const auto &[level, value] = data[i];
-            if (value >= 10) {
-                std::vector<std::tuple<int, int>> new_data;
-                std::copy(data.begin(), data.begin() + i, std::back_inserter(new_data));
-                new_data.push_back({level + 1, value / 2});
-                new_data.push_back({level + 1, value - value / 2});
-                std::copy(data.begin() + i + 1, data.end(), std::back_inserter(new_data));
-                return Number{new_data};
+    // Leftmost split first, as the rules require. A split at depth four makes a
+    // depth-five pair that explodes straight away; that can only push its left
+    // neighbour to 10 or more, so the scan steps back one place and carries on.
+    void split_all() {
+        for (int i = 0; i < size;) {
+            if (value[i] < 10) {
+                ++i;
+                continue;
+            }
+            const uint8_t low = value[i] / 2, high = value[i] - low;
+            if (depth[i] < 4) {
+                std::copy_backward(depth.begin() + i + 1, depth.begin() + size, depth.begin() + size + 1);
+                std::copy_backward(value.begin() + i + 1, value.begin() + size, value.begin() + size + 1);
+                ++size;
+                depth[i] = depth[i + 1] = depth[i] + 1;
+                value[i] = low;
+                value[i + 1] = high;
+                continue;
+            }
+            value[i] = 0;
+            if (i + 1 < size) {
+                value[i + 1] += high;
+            }
+            if (i > 0) {
+                value[i - 1] += low;
+                --i;
             }
         }
-        return std::nullopt;
     }
 
-    Number reduce() const;
+    void reduce() {
+        explode_all();
+        split_all();
+    }
 
-    Number add(Number other) const {
-        std::vector<std::tuple<int, int>> new_data;
-        for (const auto &[level, value] : data) {
-            new_data.push_back({level + 1, value});
+    Number add(const Number &other) const {
+        Number rv;
+        rv.size = size + other.size;
+        for (int i = 0; i < size; ++i) {
+            rv.depth[i] = depth[i] + 1;
+            rv.value[i] = value[i];
         }
-        for (const auto &[level, value] : other.data) {
-            new_data.push_back({level + 1, value});
+        for (int i = 0; i < other.size; ++i) {
+            rv.depth[size + i] = other.depth[i] + 1;
+            rv.value[size + i] = other.value[i];
         }
-        return Number{new_data}.reduce();
+        rv.reduce();
+        return rv;
     }
 
-    std::tuple<int, int64_t> magnitude(int start = 0, int level = 0) const {
-        const auto &[data_level, data_value] = data[start];
-        if (data_level == level) {
-            return {start + 1, data_value};
-        } else if (level > data_level) {
-            abort();
+    // Folds the regular numbers left to right on a stack, merging the top two entries
+    // whenever they are siblings (same depth).
+    int64_t magnitude() const {
+        std::array<std::tuple<int, int64_t>, CAPACITY> stack;
+        int top = 0;
+        for (int i = 0; i < size; ++i) {
+            stack[top++] = {depth[i], value[i]};
+            while (top >= 2 && std::get<0>(stack[top - 1]) == std::get<0>(stack[top - 2])) {
+                const auto &[level, right] = stack[top - 1];
+                const auto &[_level, left] = stack[top - 2];
+                stack[top - 2] = {level - 1, 3 * left + 2 * right};
+                --top;
+            }
         }
-        const auto &[left_end, left_value] = magnitude(start, level + 1);
-        const auto &[right_end, right_value] = magnitude(left_end, level + 1);
-        return {right_end, 3 * left_value + 2 * right_value};
+        return std::get<1>(stack[0]);
     }
 };
 
 std::ostream &operator<<(std::ostream &os, const Number &n) {
     std::string sep{""};
-    for (const auto &[level, value] : n.data) {
-        os << sep << "(" << level << "," << value << ")";
+    for (int i = 0; i < n.size; ++i) {
+        os << sep << "(" << int{n.depth[i]} << "," << int{n.value[i]} << ")";
         sep = ", ";
     }
     return os;
 }
 
-Number Number::reduce() const {
-    Number rv{*this};
-    //std::cerr << "original: " << *this << "\n";
-    for (int iteration = 1; iteration <= 1000; ++iteration) {
-        if (auto next = rv.reduce_nested(); next) {
-            rv = *next;
-            //std::cerr << "r nested: " << rv << "\n";
-            continue;
-        }
-        if (auto next = rv.reduce_split(); next) {
-            rv = *next;
-            //std::cerr << "r split:  " << rv << "\n";
-            continue;
-        }
-        break;
+void read_input(const Utils::InputView &input, auto fn) {
+    auto tokenizer = input.tokenizer();
+    while (auto line = tokenizer.next_word()) {
+        fn(*line);
     }
-    return rv;
 }
 
-void read_input(std::istringstream &is, auto fn) {
-    std::string line;
-    while (is >> line) {
-        fn(std::string_view{line});
-    }
-}
-
-auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
     bool first_read = true;
     Number n;
     read_input(is, [&](auto line) {
@@ -135,37 +157,140 @@ auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
             n = n.add(x);
         }
     });
-    const auto &[_end, magnitude] = n.magnitude();
-    os << magnitude;
+    os << n.magnitude();
 };
 
-auto solve2 = [](std::istringstream &is, std::ostringstream &os) {
-    std::vector<Number> ns;
-    read_input(is, [&](auto line) {
-        ns.push_back(Number::from_sv(line));
-    });
-    int64_t max_magnitude = std::numeric_limits<int64_t>::min();
-    for (int i = 0; i < std::ssize(ns); ++i) {
-        for (int j = 0; j < std::ssize(ns); ++j) {
-            if (i == j) {
-                continue;
-            }
-            const auto &[_end, magnitude] = ns[i].add(ns[j]).magnitude();
-            max_magnitude = std::max(max_magnitude, magnitude);
+// Sum of the regular numbers. Reduction never increases it: splits keep it and explodes
+// keep it or drop what falls off either end.
+int mass(const Number &n) {
+    int rv = 0;
+    for (int i = 0; i < n.size; ++i) {
+        rv += n.value[i];
+    }
+    return rv;
+}
+
+// Largest magnitude any reduced number of the given mass can have. Each regular number
+// sits at depth at most four and holds at most 9, and moving one down to the leftmost
+// leaf under it in a complete depth-four tree only raises its weight. So the bound is
+// the 16 weights of that complete tree, 3^l * 2^(4-l), filled greedily from the
+// heaviest, 9 at a time.
+const std::array<int64_t, 16 * 9 + 1> MAGNITUDE_BOUND = []() {
+    std::array<int64_t, 16> weights{};
+    for (int leaf = 0; leaf < 16; ++leaf) {
+        weights[leaf] = 1;
+        for (int bit = 0; bit < 4; ++bit) {
+            weights[leaf] *= (leaf >> bit) & 1 ? 2 : 3;
         }
     }
-    os << max_magnitude;
-};
+    std::sort(weights.begin(), weights.end(), std::greater<>());
+    std::array<int64_t, 16 * 9 + 1> rv{};
+    for (int m = 1; m <= 16 * 9; ++m) {
+        rv[m] = rv[m - 1] + weights[(m - 1) / 9];
+    }
+    return rv;
+}();
 
-void main() {
-    {
-        Utils::Tester tester{"day18"};
+int64_t magnitude_bound(int m) {
+    return MAGNITUDE_BOUND[std::min<int>(m, 16 * 9)];
+}
 
-        tester.test("part1", "in1", "4140", solve1);
-        tester.test("part1", "in2", "3884", solve1);
+// Largest magnitude of a + b over ordered pairs of distinct entries. Rows are spread
+// over the pool in a stride so every task gets a mix of heavy and light rows, and each
+// task keeps its own maximum, publishing it to the shared best as it improves.
+//
+// With prune set, numbers are visited heaviest first, and a row stops at the first
+// partner whose bound on the sum's magnitude (from the pair's total mass) can't beat the
+// best so far; every later partner is lighter, so it can't either.
+int64_t max_pair_magnitude(std::vector<Number> numbers, Utils::ThreadPool &pool, bool prune) {
+    std::vector<int> masses(numbers.size());
+    if (prune) {
+        std::sort(numbers.begin(), numbers.end(), [](const Number &a, const Number &b) { return mass(a) > mass(b); });
+    }
+    for (int i = 0; i < std::ssize(numbers); ++i) {
+        masses[i] = mass(numbers[i]);
+    }
+
+    std::atomic<int64_t> best{std::numeric_limits<int64_t>::min()};
+    const int64_t n = std::ssize(numbers);
+    const int64_t strides = std::min<int64_t>(n, 4 * int64_t{pool.size()});
+    pool.parallel_for(0, strides, [&](int64_t first) {
+        int64_t local_best = best.load(std::memory_order_relaxed);
+        for (int64_t i = first; i < n; i += strides) {
+            for (int64_t j = 0; j < n; ++j) {
+                if (i == j) {
+                    continue;
+                }
+                if (prune && magnitude_bound(masses[i] + masses[j]) <= local_best) {
+                    break;
+                }
+                const int64_t magnitude = numbers[i].add(numbers[j]).magnitude();
+                if (magnitude > local_best) {
+                    local_best = magnitude;
+                    int64_t seen = best.load(std::memory_order_relaxed);
+                    while (seen < local_best && !best.compare_exchange_weak(seen, local_best, std::memory_order_relaxed)) {
+                    }
+                }
+            }
+            local_best = std::max(local_best, best.load(std::memory_order_relaxed));
+        }
+    });
+    return best.load();
+}
 
-        tester.test("part2", "in1", "3993", solve2);
-        tester.test("part2", "in2", "4595", solve2);
+std::vector<Number> read_numbers(const Utils::InputView &is) {
+    std::vector<Number> rv;
+    read_input(is, [&](auto line) {
+        rv.push_back(Number::from_sv(line));
+    });
+    return rv;
+}
+
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
+    os << max_pair_magnitude(read_numbers(is), Utils::ThreadPool::shared(), true);
+};
+
+auto solve2_exhaustive = [](const Utils::InputView &is, std::ostringstream &os) {
+    os << max_pair_magnitude(read_numbers(is), Utils::ThreadPool::shared(), false);
+};
+
+// n random reduced snailfish numbers: pairs nest at most four deep, regular numbers are
+// single digits.
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    std::string rv;
+    auto element = [&rng, &rv](auto rec, int depth) -> void {
+        if (depth > 1 && (depth > 4 || rng() % 3 == 0)) {
+            rv.push_back(static_cast<char>('0' + rng() % 10));
+            return;
+        }
+        rv.push_back('[');
+        rec(rec, depth + 1);
+        rv.push_back(',');
+        rec(rec, depth + 1);
+        rv.push_back(']');
+    };
+    for (int64_t i = 0; i < n; ++i) {
+        element(element, 1);
+        rv.push_back('\n');
     }
+    return rv;
 }
+
+const Utils::Registration registration{"Day18A", "day18", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "4140", solve1);
+    day.test("part1", "in2", "3884", solve1);
+
+    day.test("part2", "in1", "3993", solve2);
+    day.test("part2", "in2", "4595", solve2);
+    day.test("part2 exhaustive", "in1", "3993", solve2_exhaustive);
+    day.test("part2 exhaustive", "in2", "4595", solve2_exhaustive);
+
+    day.bench("part1", "in2", "3884", solve1);
+    day.bench("part2", "in2", "4595", solve2);
+    day.bench("part2 exhaustive", "in2", "4595", solve2_exhaustive);
+
+    day.generate("numbers", generate);
+    day.scaling("part1", {100, 1000, 10000, 100000}, solve1);
+    day.scaling("part2", {25, 50, 100, 200, 400, 800, 1600, 3200}, solve2);
+}};
 } // namespace Day18A
\ No newline at end of file
@@ -1,3 +0,0 @@
-namespace Day18A {
-void main();
-}
\ No newline at end of file
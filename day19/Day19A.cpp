@@ -1,5 +1,11 @@
-#include "Utils.h"
+#include "CpuFeatures.h"
+#include "Registry.h"
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
 
 namespace Day19A {
 
@@ -14,85 +20,243 @@ struct Point {
     Point operator-(const Point &other) const {
         return {x - other.x, y - other.y, z - other.z};
     }
-    Point rotate_x() const {
-        return {x, -z, y};
+};
+
+// The 24 orientations as signed axis permutations: rotated[k] = sign[k] * point[axis[k]].
+// Even permutations take an even number of sign flips and odd ones an odd number, so
+// every matrix has determinant +1. The identity comes first.
+struct Rotation {
+    std::array<int, 3> axis, sign;
+
+    Point apply(const Point &p) const {
+        const std::array<int, 3> c{p.x, p.y, p.z};
+        return {sign[0] * c[axis[0]], sign[1] * c[axis[1]], sign[2] * c[axis[2]]};
+    }
+};
+
+constexpr std::array<Rotation, 24> ROTATIONS = []() {
+    std::array<Rotation, 24> rv{};
+    int count = 0;
+    std::array<int, 3> perm{0, 1, 2};
+    do {
+        const int parity = (perm[0] > perm[1]) + (perm[0] > perm[2]) + (perm[1] > perm[2]);
+        for (int signs = 0; signs < 8; ++signs) {
+            const std::array<int, 3> sign{signs & 1 ? -1 : 1, signs & 2 ? -1 : 1, signs & 4 ? -1 : 1};
+            if ((parity % 2 == 0 ? 1 : -1) * sign[0] * sign[1] * sign[2] == 1) {
+                rv[count++] = {perm, sign};
+            }
+        }
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    return rv;
+}();
+
+// Beacon coordinates as separate x, y and z arrays, zero-padded to a multiple of eight
+// so the AVX2 path has no scalar tail.
+struct BeaconLanes {
+    int size = 0;
+    std::vector<int32_t> x, y, z;
+
+    static BeaconLanes from_points(const std::vector<Point> &points) {
+        BeaconLanes rv;
+        rv.size = static_cast<int>(points.size());
+        const std::size_t padded = (points.size() + 7) / 8 * 8;
+        rv.x.assign(padded, 0);
+        rv.y.assign(padded, 0);
+        rv.z.assign(padded, 0);
+        for (int i = 0; i < rv.size; ++i) {
+            rv.x[i] = points[i].x;
+            rv.y[i] = points[i].y;
+            rv.z[i] = points[i].z;
+        }
+        return rv;
+    }
+
+    Point at(int i) const {
+        return {x[i], y[i], z[i]};
+    }
+
+    const std::vector<int32_t> &axis(int k) const {
+        return k == 0 ? x : k == 1 ? y : z;
     }
-    Point rotate_y() const {
-        return {z, y, -x};
+
+    BeaconLanes rotated_scalar(const Rotation &r) const {
+        BeaconLanes rv{size, x, y, z};
+        std::array<std::vector<int32_t> *, 3> out{&rv.x, &rv.y, &rv.z};
+        for (int k = 0; k < 3; ++k) {
+            const auto &src = axis(r.axis[k]);
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                (*out[k])[i] = r.sign[k] * src[i];
+            }
+        }
+        return rv;
     }
-    Point rotate_z() const {
-        return {-y, x, z};
+
+#ifdef UTILS_X86
+    // One load, one sign instruction and one store per eight coordinates.
+    UTILS_TARGET("avx2")
+    BeaconLanes rotated_avx2(const Rotation &r) const {
+        BeaconLanes rv{size, x, y, z};
+        std::array<std::vector<int32_t> *, 3> out{&rv.x, &rv.y, &rv.z};
+        for (int k = 0; k < 3; ++k) {
+            const int32_t *src = axis(r.axis[k]).data();
+            int32_t *dst = out[k]->data();
+            const __m256i sign = _mm256_set1_epi32(r.sign[k]);
+            for (std::size_t i = 0; i < x.size(); i += 8) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_sign_epi32(v, sign));
+            }
+        }
+        return rv;
+    }
+#endif
+
+    BeaconLanes rotated(const Rotation &r) const {
+#ifdef UTILS_X86
+        if (Utils::CpuFeatures::get().avx2) {
+            return rotated_avx2(r);
+        }
+#endif
+        return rotated_scalar(r);
     }
 };
 
-struct Scanner {
-    int id;
-    std::vector<Point> beacons;
-    Point shift{};
+// Beacon positions in an open-addressing hash set, for constant-time "is there a beacon
+// here" probes. Sized up front for the points it will hold, so it never rehashes.
+struct BeaconSet {
+    static constexpr uint64_t EMPTY = ~uint64_t{0};
 
-    Scanner transform(auto fn) const {
-        std::vector<Point> new_points(beacons.size());
-        std::transform(beacons.begin(), beacons.end(), new_points.begin(), fn);
-        std::sort(new_points.begin(), new_points.end());
-        return {id, new_points};
+    std::vector<uint64_t> keys;
+    uint64_t mask = 0;
+    int size = 0;
+
+    // Room for `points` beacons at most half full.
+    static BeaconSet with_capacity(std::size_t points) {
+        const std::size_t capacity = std::bit_ceil(2 * std::max<std::size_t>(points, 8));
+        return {std::vector<uint64_t>(capacity, EMPTY), capacity - 1};
     }
 
-    Scanner rotate_x() const {
-        return transform([](const Point &p) { return p.rotate_x(); });
+    static BeaconSet from_points(const std::vector<Point> &points) {
+        BeaconSet rv{with_capacity(points.size())};
+        for (const Point &p : points) {
+            rv.insert(p);
+        }
+        return rv;
     }
-    Scanner rotate_y() const {
-        return transform([](const Point &p) { return p.rotate_y(); });
+
+    // Coordinates are biased into 21 bits each, which covers surveys a million units
+    // across, and keeps every key clear of EMPTY.
+    static constexpr int BIAS = 1 << 20;
+
+    static bool in_range(const Point &p) {
+        auto fits = [](int c) { return -BIAS <= c && c < BIAS; };
+        return fits(p.x) && fits(p.y) && fits(p.z);
+    }
+
+    static uint64_t key_of(const Point &p) {
+        const uint64_t bias = BIAS;
+        return ((p.x + bias) << 42) | ((p.y + bias) << 21) | (p.z + bias);
     }
-    Scanner rotate_z() const {
-        return transform([](const Point &p) { return p.rotate_z(); });
+
+    uint64_t first_slot(uint64_t key) const {
+        return (key * 0x9e3779b97f4a7c15ull) >> 32 & mask;
     }
 
-    void for_each_rotation(auto fn) const {
-        Scanner current_rotation{*this};
-        for (int rotations_around_x = 0; rotations_around_x < 4; ++rotations_around_x) {
-            fn(current_rotation);
-            fn(current_rotation.rotate_z());                       // x faces y
-            fn(current_rotation.rotate_y());                       // x faces -z
-            fn(current_rotation.rotate_z().rotate_z());            // x faces -x
-            fn(current_rotation.rotate_z().rotate_z().rotate_z()); // x faces -y
-            fn(current_rotation.rotate_y().rotate_y().rotate_y()); // x faces z
-            current_rotation = current_rotation.rotate_x();
+    bool insert(const Point &p) {
+        if (!in_range(p)) {
+            std::cerr << "ERROR: Beacon " << p.x << "," << p.y << "," << p.z << " too far out to store\n";
+            abort();
+        }
+        const uint64_t key = key_of(p);
+        for (uint64_t slot = first_slot(key);; slot = (slot + 1) & mask) {
+            if (keys[slot] == EMPTY) {
+                keys[slot] = key;
+                ++size;
+                return true;
+            }
+            if (keys[slot] == key) {
+                return false;
+            }
         }
     }
 
-    void for_each_candidate_delta(const Scanner &reference, auto fn) const {
-        // *this + delta = reference  =>  delta = reference - *this
-        for (const Point &my_point : beacons) {
-            for (const Point &their_point : reference.beacons) {
-                fn(their_point - my_point);
+    // Points out of range can't have been inserted, and would alias if packed.
+    bool contains(const Point &p) const {
+        if (!in_range(p)) {
+            return false;
+        }
+        const uint64_t key = key_of(p);
+        for (uint64_t slot = first_slot(key);; slot = (slot + 1) & mask) {
+            if (keys[slot] == key) {
+                return true;
+            }
+            if (keys[slot] == EMPTY) {
+                return false;
             }
         }
     }
+};
+
+// Rotation- and translation-invariant signature of a pair of beacons: the absolute
+// differences along each axis, sorted, packed 21 bits apiece.
+uint64_t fingerprint(const Point &a, const Point &b) {
+    std::array<uint64_t, 3> d{static_cast<uint64_t>(std::abs(a.x - b.x)), static_cast<uint64_t>(std::abs(a.y - b.y)),
+                              static_cast<uint64_t>(std::abs(a.z - b.z))};
+    std::sort(d.begin(), d.end());
+    return (d[0] << 42) | (d[1] << 21) | d[2];
+}
+
+struct PairFingerprint {
+    uint64_t value;
+    int i, j; // indices of the two beacons
+
+    auto operator<=>(const PairFingerprint &other) const = default;
+};
+
+const int MIN_SHARED_BEACONS = 12;
+
+// Twelve shared beacons make 12 choose 2 shared beacon pairs, and so at least as many
+// shared fingerprints.
+const int MIN_SHARED_FINGERPRINTS = 66;
+
+struct Scanner {
+    int id;
+    std::vector<Point> beacons;
+    Point shift{};
+    // Sorted by value, one per beacon pair. Aligned scanners keep their beacons in the
+    // order they were read, so they carry these over unchanged.
+    std::vector<PairFingerprint> fingerprints{};
+    // The beacons in each of ROTATIONS, built once when the scanner is read, since every
+    // match attempt against any reference goes through all 24.
+    std::vector<BeaconLanes> rotations{};
+    BeaconSet beacon_set{};
 
-    void for_each_delta_candidate(const Scanner &reference, auto fn) const {
-        for_each_candidate_delta(reference, [&](const Point &delta) {
-            Scanner new_scanner{transform([&](const Point &p) { return p + delta; })};
-            new_scanner.shift = delta;
-            fn(new_scanner);
-        });
+    void compute_rotations() {
+        const BeaconLanes lanes = BeaconLanes::from_points(beacons);
+        rotations.clear();
+        for (const Rotation &r : ROTATIONS) {
+            rotations.push_back(lanes.rotated(r));
+        }
     }
 
-    void for_each_all_candidate(const Scanner &reference, auto fn) const {
-        for_each_rotation([&](const Scanner &rotated_scanner) {
-            rotated_scanner.for_each_delta_candidate(reference, [&](const Scanner &deltad_scanner) {
-                fn(deltad_scanner);
-            });
-        });
+    void compute_fingerprints() {
+        fingerprints.clear();
+        for (int i = 0; i < std::ssize(beacons); ++i) {
+            for (int j = i + 1; j < std::ssize(beacons); ++j) {
+                fingerprints.push_back({fingerprint(beacons[i], beacons[j]), i, j});
+            }
+        }
+        std::sort(fingerprints.begin(), fingerprints.end());
     }
 
-    int common_points(const Scanner &other) const {
-        assert(std::is_sorted(beacons.begin(), beacons.end()));
-        assert(std::is_sorted(other.beacons.begin(), other.beacons.end()));
+    // Size of the multiset intersection of both scanners' fingerprints. Scanners that
+    // overlap in 12 beacons always reach MIN_SHARED_FINGERPRINTS, so a lower count rules
+    // a pair out without trying any alignment.
+    int shared_fingerprints(const Scanner &other) const {
         int rv = 0;
-        for (auto it{beacons.begin()}, jt{other.beacons.begin()}; it != beacons.end() && jt != other.beacons.end();) {
-            if (*it < *jt) {
+        for (auto it{fingerprints.begin()}, jt{other.fingerprints.begin()}; it != fingerprints.end() && jt != other.fingerprints.end();) {
+            if (it->value < jt->value) {
                 ++it;
-            } else if (*it > *jt) {
+            } else if (it->value > jt->value) {
                 ++jt;
             } else {
                 ++rv;
@@ -103,43 +267,110 @@ struct Scanner {
         return rv;
     }
 
+    Scanner transform(auto fn) const {
+        std::vector<Point> new_points(beacons.size());
+        std::transform(beacons.begin(), beacons.end(), new_points.begin(), fn);
+        Scanner rv{id, std::move(new_points)};
+        rv.fingerprints = fingerprints;
+        rv.beacon_set = BeaconSet::from_points(rv.beacons);
+        return rv;
+    }
+
+    // Probes my beacons, rotated and shifted, against the reference's, stopping as soon as
+    // enough are found or too few are left to get there.
+    static bool shares_enough(const BeaconLanes &rotated, const Point &delta, const BeaconSet &reference) {
+        int hits = 0;
+        for (int k = 0; k < rotated.size && hits + (rotated.size - k) >= MIN_SHARED_BEACONS; ++k) {
+            if (reference.contains(rotated.at(k) + delta) && ++hits == MIN_SHARED_BEACONS) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Every fingerprint the scanners share pairs two of my beacons with two of the
+    // reference's, and each rotation that lines the pairs up, one way round or the other,
+    // fixes a shift to probe. A real overlap shares at least MIN_SHARED_FINGERPRINTS such
+    // pairs, each of which seeds the right rotation and shift, so trying every seed is
+    // exhaustive.
     std::optional<Scanner> match(const Scanner &reference) const {
-        std::optional<Scanner> rv{std::nullopt};
-        for_each_all_candidate(reference, [&](const Scanner &candidate) {
-            if (reference.common_points(candidate) >= 12 && !rv.has_value()) {
-                rv = candidate;
+        UTILS_TRACE_SCOPE("Scanner::match", "scanner", id, "reference", reference.id);
+        auto try_seed = [&](const PairFingerprint &mine, const PairFingerprint &theirs) -> std::optional<Scanner> {
+            const Point &c = reference.beacons[theirs.i], &d = reference.beacons[theirs.j];
+            for (int r = 0; r < std::ssize(ROTATIONS); ++r) {
+                const Point a = rotations[r].at(mine.i), b = rotations[r].at(mine.j);
+                for (const auto &[to_a, to_b] : {std::pair{c, d}, std::pair{d, c}}) {
+                    if (b - a != to_b - to_a) {
+                        continue;
+                    }
+                    // *this + delta = reference  =>  delta = reference - *this
+                    const Point delta = to_a - a;
+                    if (shares_enough(rotations[r], delta, reference.beacon_set)) {
+                        Scanner rv{transform([&](const Point &p) { return ROTATIONS[r].apply(p) + delta; })};
+                        rv.shift = delta;
+                        return rv;
+                    }
+                }
             }
-        });
-        return rv;
+            return std::nullopt;
+        };
+
+        auto run_end = [](auto it, auto end) {
+            return std::find_if(it, end, [&](const PairFingerprint &f) { return f.value != it->value; });
+        };
+        for (auto it{fingerprints.begin()}, jt{reference.fingerprints.begin()}; it != fingerprints.end() && jt != reference.fingerprints.end();) {
+            if (it->value < jt->value) {
+                ++it;
+            } else if (it->value > jt->value) {
+                ++jt;
+            } else {
+                const auto it_end = run_end(it, fingerprints.end());
+                const auto jt_end = run_end(jt, reference.fingerprints.end());
+                for (auto mine = it; mine != it_end; ++mine) {
+                    for (auto theirs = jt; theirs != jt_end; ++theirs) {
+                        if (auto rv = try_seed(*mine, *theirs)) {
+                            return rv;
+                        }
+                    }
+                }
+                it = it_end;
+                jt = jt_end;
+            }
+        }
+        return std::nullopt;
     }
 
-    static std::optional<Scanner> read(std::istringstream &is, int id) {
-        std::string line;
-        std::getline(is, line);
-        if (line.find("scanner") == std::string::npos) {
+    static std::optional<Scanner> read(Utils::Tokenizer &tokenizer, int id) {
+        auto header = tokenizer.next_line();
+        if (!header.has_value() || header->find("scanner") == std::string_view::npos) {
             return std::nullopt;
         }
         Scanner rv{id};
-        while (true) {
-            std::getline(is, line);
-            if (!is || line.find(',') == std::string::npos) {
+        while (auto line = tokenizer.next_line()) {
+            if (line->find(',') == std::string_view::npos) {
                 break;
             }
-            int x, y, z;
-            char ch;
-            std::istringstream{line} >> x >> ch >> y >> ch >> z;
+            Utils::Tokenizer coords{*line};
+            int x = static_cast<int>(coords.expect_int());
+            int y = static_cast<int>(coords.expect_int());
+            int z = static_cast<int>(coords.expect_int());
             rv.beacons.push_back({x, y, z});
         }
         std::sort(rv.beacons.begin(), rv.beacons.end());
+        rv.compute_fingerprints();
+        rv.compute_rotations();
+        rv.beacon_set = BeaconSet::from_points(rv.beacons);
         return rv;
     }
 };
 
-std::vector<Scanner> read_scanners(std::istringstream &is) {
+std::vector<Scanner> read_scanners(const Utils::InputView &input) {
+    UTILS_TRACE_SCOPE("parse");
+    auto tokenizer = input.tokenizer();
     std::vector<Scanner> scanners;
     int scanner_index = 0;
     while (true) {
-        auto s{Scanner::read(is, scanner_index++)};
+        auto s{Scanner::read(tokenizer, scanner_index++)};
         if (!s.has_value()) {
             break;
         }
@@ -148,40 +379,84 @@ std::vector<Scanner> read_scanners(std::istringstream &is) {
     return scanners;
 }
 
-auto solve = [](std::istringstream &is, std::ostringstream &os, int which_part) {
-    const auto original_scanners = read_scanners(is);
-    assert(original_scanners.size() > 0);
+// Aligns every scanner to scanner 0's frame, growing out over the overlap graph. Each
+// time a scanner is aligned, a job is queued on the pool for every unaligned scanner whose
+// fingerprints say it could overlap it; a job matches that pair once. Several jobs may
+// find the same scanner, and the first to claim it publishes its alignment and queues the
+// next jobs, so no pair is ever attempted twice and later jobs for a claimed scanner
+// return straight away.
+std::vector<Scanner> align_scanners(const std::vector<Scanner> &original_scanners, Utils::ThreadPool &pool) {
+    UTILS_TRACE_SCOPE("align_scanners");
+    const int n = static_cast<int>(original_scanners.size());
+    std::vector<std::optional<Scanner>> aligned(n);
+    std::vector<std::atomic<bool>> claimed(n);
+    std::mutex mutex;
+    std::condition_variable idle;
+    int pending = 0;
 
-    std::vector<Scanner> stable{original_scanners[0]};
-    auto finding_loop = [&]() {
-        for (const auto &scanner_to_attempt : original_scanners) {
-            if (std::any_of(stable.begin(), stable.end(), [&](const Scanner &matched) { return matched.id == scanner_to_attempt.id; })) {
+    std::function<void(int)> on_aligned = [&](int reference_id) {
+        for (int u = 0; u < n; ++u) {
+            if (claimed[u].load(std::memory_order_acquire) ||
+                original_scanners[u].shared_fingerprints(original_scanners[reference_id]) < MIN_SHARED_FINGERPRINTS) {
                 continue;
             }
-
-            for (const auto &stable_to_attempt : stable) {
-                auto maybe_matched{scanner_to_attempt.match(stable_to_attempt)};
-                if (maybe_matched.has_value()) {
-                    stable.push_back(*maybe_matched);
-                    return;
-                }
+            {
+                std::lock_guard lock{mutex};
+                ++pending;
             }
+            pool.submit([&, u, reference_id]() {
+                if (!claimed[u].load(std::memory_order_acquire)) {
+                    auto maybe_matched{original_scanners[u].match(*aligned[reference_id])};
+                    if (maybe_matched.has_value() && !claimed[u].exchange(true, std::memory_order_acq_rel)) {
+                        aligned[u] = std::move(maybe_matched);
+                        on_aligned(u);
+                    }
+                }
+                std::lock_guard lock{mutex};
+                if (--pending == 0) {
+                    idle.notify_all();
+                }
+            });
         }
-        abort();
     };
-    while (stable.size() < original_scanners.size()) {
-        std::cout << "scanners matched: " << stable.size() << "\n";
-        finding_loop();
+
+    claimed[0] = true;
+    aligned[0] = original_scanners[0];
+    on_aligned(0);
+    {
+        std::unique_lock lock{mutex};
+        idle.wait(lock, [&]() { return pending == 0; });
     }
 
+    std::vector<Scanner> rv;
+    for (auto &scanner : aligned) {
+        if (!scanner.has_value()) {
+            std::cerr << "ERROR: Scanner " << rv.size() << " could not be aligned\n";
+            abort();
+        }
+        rv.push_back(std::move(*scanner));
+    }
+    return rv;
+}
+
+auto solve = [](const Utils::InputView &is, std::ostringstream &os, int which_part) {
+    const auto original_scanners = read_scanners(is);
+    assert(original_scanners.size() > 0);
+
+    const auto stable = align_scanners(original_scanners, Utils::ThreadPool::shared());
+
     if (which_part == 1) {
-        std::vector<Point> all_points;
+        std::size_t total_beacons = 0;
         for (const auto &scanner : stable) {
-            std::copy(scanner.beacons.begin(), scanner.beacons.end(), std::back_inserter(all_points));
+            total_beacons += scanner.beacons.size();
+        }
+        BeaconSet all_points{BeaconSet::with_capacity(total_beacons)};
+        for (const auto &scanner : stable) {
+            for (const Point &p : scanner.beacons) {
+                all_points.insert(p);
+            }
         }
-        std::sort(all_points.begin(), all_points.end());
-        all_points.erase(std::unique(all_points.begin(), all_points.end()), all_points.end());
-        os << all_points.size();
+        os << all_points.size;
     } else if (which_part == 2) {
         int max_manhattan = std::numeric_limits<int>::min();
         for (const auto &scanner_1 : stable) {
@@ -197,15 +472,71 @@ auto solve = [](std::istringstream &is, std::ostringstream &os, int which_part)
     }
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day19"};
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) { return solve(is, os, 1); };
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) { return solve(is, os, 2); };
 
-        tester.test("part1", "in1", "79", [](auto &is, auto &os) { return solve(is, os, 1); });
-        tester.test("part1", "in2", "467", [](auto &is, auto &os) { return solve(is, os, 1); });
+// n scanners in a loose chain. Each one sits within 1100 units per axis of one of the
+// previous three and shares 12 planted beacons with it, on top of 14 of its own; every
+// scanner then reports all beacons within 1000 units, in one of the 24 orientations
+// (scanner 0 unrotated).
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    using Coord = std::array<int, 3>;
+    auto uniform = [&rng](int lo, int hi) {
+        return lo + static_cast<int>(rng() % static_cast<uint64_t>(hi - lo + 1));
+    };
 
-        tester.test("part2", "in1", "3621", [](auto &is, auto &os) { return solve(is, os, 2); });
-        tester.test("part2", "in2", "12226", [](auto &is, auto &os) { return solve(is, os, 2); });
+    std::vector<Coord> positions{{0, 0, 0}};
+    std::vector<Coord> beacons;
+    auto plant = [&](const Coord &a, const Coord &b, int count) {
+        for (int i = 0; i < count; ++i) {
+            Coord c;
+            for (int k = 0; k < 3; ++k) {
+                c[k] = uniform(std::max(a[k], b[k]) - 1000, std::min(a[k], b[k]) + 1000);
+            }
+            beacons.push_back(c);
+        }
+    };
+    plant(positions[0], positions[0], 14);
+    for (int64_t i = 1; i < n; ++i) {
+        const Coord parent = positions[i - 1 - static_cast<int64_t>(rng() % std::min<int64_t>(i, 3))];
+        Coord pos;
+        for (int k = 0; k < 3; ++k) {
+            pos[k] = parent[k] + uniform(-1100, 1100);
+        }
+        positions.push_back(pos);
+        plant(parent, pos, 12);
+        plant(pos, pos, 14);
     }
+    std::sort(beacons.begin(), beacons.end());
+    beacons.erase(std::unique(beacons.begin(), beacons.end()), beacons.end());
+
+    std::ostringstream os;
+    for (int64_t i = 0; i < n; ++i) {
+        const auto &[axes, sign] = ROTATIONS[i == 0 ? 0 : rng() % ROTATIONS.size()];
+        os << "--- scanner " << i << " ---\n";
+        for (const Coord &b : beacons) {
+            Coord rel{b[0] - positions[i][0], b[1] - positions[i][1], b[2] - positions[i][2]};
+            if (std::abs(rel[0]) > 1000 || std::abs(rel[1]) > 1000 || std::abs(rel[2]) > 1000) {
+                continue;
+            }
+            os << sign[0] * rel[axes[0]] << "," << sign[1] * rel[axes[1]] << "," << sign[2] * rel[axes[2]] << "\n";
+        }
+        os << "\n";
+    }
+    return os.str();
 }
+
+const Utils::Registration registration{"Day19A", "day19", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "79", solve1);
+    day.test("part1", "in2", "467", solve1);
+
+    day.test("part2", "in1", "3621", solve2);
+    day.test("part2", "in2", "12226", solve2);
+
+    day.bench("part1", "in2", "467", solve1);
+    day.bench("part2", "in2", "12226", solve2);
+
+    day.generate("scanners", generate);
+    day.scaling("part1", {2, 4, 8, 16, 32, 64, 128, 256}, solve1);
+}};
 } // namespace Day19A
\ No newline at end of file
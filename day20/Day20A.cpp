@@ -1,21 +1,25 @@
-#include "Utils.h"
+#include "Registry.h"
+#include <array>
 
 namespace Day20A {
 
 const int N = 500;
-char matrix[N][N];
-char tmpmtx[N][N];
 
-auto solve = [](std::istringstream &is, std::ostringstream &os, int enhancement_count) {
-    std::string enhance;
-    is >> enhance;
+auto solve = [](const Utils::InputView &is, std::ostringstream &os, int enhancement_count) {
+    auto tokenizer = is.tokenizer();
+    const std::string_view enhance = tokenizer.expect_word();
 
-    std::vector<std::string> input;
-    std::copy(std::istream_iterator<std::string>(is), std::istream_iterator<std::string>(), std::back_inserter(input));
+    std::vector<std::string_view> input;
+    while (auto row = tokenizer.next_word()) {
+        input.push_back(*row);
+    }
     int inputR = std::ssize(input);
     int inputC = std::ssize(input[0]);
 
-    memset(matrix, '.', sizeof(matrix));
+    std::vector<std::array<char, N>> matrix(N), tmpmtx(N);
+    for (auto &row : matrix) {
+        row.fill('.');
+    }
     for (int r = 0; r < inputR; ++r) {
         for (int c = 0; c < inputC; ++c) {
             matrix[N / 2 - inputR / 2 + r][N / 2 - inputC / 2 + c] = input[r][c];
@@ -23,14 +27,7 @@ auto solve = [](std::istringstream &is, std::ostringstream &os, int enhancement_
     }
 
     for (int count = 0; count < enhancement_count; ++count) {
-        int on_count = 0;
-        for (int r = 0; r < N; ++r) {
-            for (int c = 0; c < N; ++c) {
-                on_count += matrix[r][c] == '#';
-            }
-        }
-        std::cout << "before iter=" << count << ": count=" << on_count << "\n";
-
+        UTILS_TRACE_SCOPE("enhance", "round", count);
         for (int r = 0; r < N; ++r) {
             for (int c = 0; c < N; ++c) {
                 int enhance_idx = 0;
@@ -49,7 +46,7 @@ auto solve = [](std::istringstream &is, std::ostringstream &os, int enhancement_
                 tmpmtx[r][c] = enhance[enhance_idx];
             }
         }
-        memcpy(matrix, tmpmtx, sizeof(tmpmtx));
+        std::swap(matrix, tmpmtx);
     }
 
     int on_count = 0;
@@ -61,19 +58,44 @@ auto solve = [](std::istringstream &is, std::ostringstream &os, int enhancement_
     os << on_count;
 };
 
-auto solve1 = [](auto &is, auto &os) { return solve(is, os, 2); };
-auto solve2 = [](auto &is, auto &os) { return solve(is, os, 50); };
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) { return solve(is, os, 2); };
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) { return solve(is, os, 50); };
 
-void main() {
-    {
-        Utils::Tester tester{"day20"};
-
-        tester.test("part1", "in1", "35", solve1);
-        tester.test("part1", "in2", "5819", solve1);
-        tester.test("part1", "in1", "35", solve1);
-        tester.test("part1", "in2", "5819", solve1);
-        tester.test("part2", "in1", "3351", solve2);
-        tester.test("part2", "in2", "", solve2);
+// Random n x n image and enhancement table. Half the tables flip the infinite background
+// every round like the real inputs do ('#' at 0, '.' at 511). The solver's canvas is
+// N x N, so part 2 needs n + 100 comfortably below N.
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    std::string rv;
+    for (int i = 0; i < 512; ++i) {
+        rv.push_back(rng() % 2 ? '#' : '.');
+    }
+    const bool flips = rng() % 2;
+    rv[0] = flips ? '#' : '.';
+    rv[511] = '.';
+    rv += "\n\n";
+    for (int64_t r = 0; r < n; ++r) {
+        for (int64_t c = 0; c < n; ++c) {
+            rv.push_back(rng() % 2 ? '#' : '.');
+        }
+        rv.push_back('\n');
     }
+    return rv;
 }
+
+const Utils::Registration registration{"Day20A", "day20", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "35", solve1);
+    day.test("part1", "in2", "5819", solve1);
+    day.test("part1", "in1", "35", solve1);
+    day.test("part1", "in2", "5819", solve1);
+    day.test("part2", "in1", "3351", solve2);
+    // Recorded from this solver's own output, then confirmed by a separate direct
+    // simulation that tracks the lit state of the infinite background.
+    day.test("part2", "in2", "18516", solve2);
+
+    day.bench("part1", "in2", "5819", solve1);
+    day.bench("part2", "in2", "18516", solve2);
+
+    day.generate("image side", generate);
+    day.scaling("part2", {25, 50, 100, 200, 350}, solve2);
+}};
 } // namespace Day20A
\ No newline at end of file
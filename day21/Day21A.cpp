@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <map>
 
 namespace Day21A {
@@ -7,10 +7,18 @@ int roll(int x) {
     return (x - 1) % 10 + 1;
 }
 
-auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
-    std::string buf;
-    int p1start, p2start;
-    is >> buf >> buf >> buf >> buf >> p1start >> buf >> buf >> buf >> buf >> p2start;
+// "Player 1 starting position: 4" twice; the player numbers are skipped.
+std::tuple<int, int> read_input(const Utils::InputView &input) {
+    auto tokenizer = input.tokenizer();
+    tokenizer.expect_int();
+    int p1start = static_cast<int>(tokenizer.expect_int());
+    tokenizer.expect_int();
+    int p2start = static_cast<int>(tokenizer.expect_int());
+    return {p1start, p2start};
+}
+
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
+    const auto [p1start, p2start] = read_input(is);
 
     int p1 = p1start, p2 = p2start;
     int64_t p1score = 0, p2score = 0;
@@ -40,9 +48,6 @@ auto solve1 = [](std::istringstream &is, std::ostringstream &os) {
         }
     }
 
-    std::cout << "losingscore=" << losingscore << "\n";
-    std::cout << "dierolls=   " << dierolls << "\n";
-
     os << losingscore * dierolls;
 };
 
@@ -56,10 +61,8 @@ const std::vector<std::tuple<int, int>> ROLLS = {
     {9, 1},
 };
 
-auto solve2 = [](std::istringstream &is, std::ostringstream &os) {
-    std::string buf;
-    int p1start, p2start;
-    is >> buf >> buf >> buf >> buf >> p1start >> buf >> buf >> buf >> buf >> p2start;
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
+    const auto [p1start, p2start] = read_input(is);
 
     const auto SENTINEL = std::tuple<int64_t, int64_t>{-1, -1};
     std::map<std::tuple<int, int, int, int>, std::tuple<int64_t, int64_t>> memo;
@@ -85,19 +88,18 @@ auto solve2 = [](std::istringstream &is, std::ostringstream &os) {
     };
 
     const auto [p1wins, p2wins] = go(go, p1start, 0, p2start, 0);
-    std::cout << "p1 wins: " << p1wins << "\n";
-    std::cout << "p2 wins: " << p2wins << "\n";
     os << std::max(p1wins, p2wins);
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day21"};
+const Utils::Registration registration{"Day21A", "day21", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "739785", solve1);
+    day.test("part1", "in2", "720750", solve1);
+    day.test("part2", "in1", "444356092776315", solve2);
+    // Recorded from this solver's own output, then confirmed by a separate memoised
+    // count over (positions, scores).
+    day.test("part2", "in2", "275067741811212", solve2);
 
-        tester.test("part1", "in1", "739785", solve1);
-        tester.test("part1", "in2", "720750", solve1);
-        tester.test("part2", "in1", "444356092776315", solve2);
-        tester.test("part2", "in2", "", solve2);
-    }
-}
+    day.bench("part1", "in2", "720750", solve1);
+    day.bench("part2", "in2", "275067741811212", solve2);
+}};
 } // namespace Day21A
\ No newline at end of file
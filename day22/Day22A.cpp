@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <cassert>
 
 namespace Day22A {
@@ -8,28 +8,25 @@ struct InputCuboid {
     int xmin, xmax, ymin, ymax, zmin, zmax;
 };
 
-std::optional<InputCuboid> read_one(std::istringstream &is) {
-    InputCuboid rv{};
-    std::string onoff, coordbuf;
-    is >> onoff >> coordbuf;
-    if (!is) {
+std::optional<InputCuboid> read_one(Utils::Tokenizer &tokenizer) {
+    auto onoff = tokenizer.next_word();
+    if (!onoff.has_value()) {
         return std::nullopt;
     }
-    rv.on = onoff == "on";
-
-    for (char &c : coordbuf) {
-        if (c != '-' && (c < '0' || c > '9')) {
-            c = ' ';
-        }
+    InputCuboid rv{};
+    rv.on = *onoff == "on";
+    for (int *coord : {&rv.xmin, &rv.xmax, &rv.ymin, &rv.ymax, &rv.zmin, &rv.zmax}) {
+        *coord = static_cast<int>(tokenizer.expect_int());
     }
-    std::istringstream{coordbuf} >> rv.xmin >> rv.xmax >> rv.ymin >> rv.ymax >> rv.zmin >> rv.zmax;
     return rv;
 }
 
-std::vector<InputCuboid> read(std::istringstream &is) {
+std::vector<InputCuboid> read(const Utils::InputView &input) {
+    UTILS_TRACE_SCOPE("parse");
+    auto tokenizer = input.tokenizer();
     std::vector<InputCuboid> rv;
     while (true) {
-        auto value = read_one(is);
+        auto value = read_one(tokenizer);
         if (!value.has_value()) {
             break;
         }
@@ -57,6 +54,7 @@ struct Reactor {
     }
 
     void ingest_cuboid(const InputCuboid &cuboid) {
+        UTILS_TRACE_SCOPE("ingest_cuboid");
         auto find_tick = [](auto &ticks, int cmin, int cmax) -> std::tuple<int, int> {
             int c_imin = std::lower_bound(ticks.begin(), ticks.end(), cmin) - ticks.begin();
             int c_imax = std::lower_bound(ticks.begin(), ticks.end(), cmax + 1) - ticks.begin();
@@ -137,24 +135,54 @@ auto solve = [](auto &is, auto &os, int min, int max) {
     os << reactor.on_count(min, max);
 };
 
-auto solve1 = [](auto &is, auto &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
     return solve(is, os, -50, 50);
 };
 
-auto solve2 = [](auto &is, auto &os) {
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
     return solve(is, os, std::numeric_limits<int>::min(), std::numeric_limits<int>::max() - 1);
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day22"};
-
-        tester.test("part1", "in1", "39", solve1);
-        tester.test("part1", "in2", "590784", solve1);
-        tester.test("part1", "in3", "609563", solve1);
-
-        tester.test("part2", "in4", "2758514936282235", solve2);
-        tester.test("part2", "in3", "", solve2);
+// n reboot steps shaped like the real ones: the first 20 stay inside the -50..50
+// initialization region, the rest are large cuboids anywhere within +-100000.
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    auto uniform = [&rng](int lo, int hi) {
+        return lo + static_cast<int>(rng() % static_cast<uint64_t>(hi - lo + 1));
+    };
+    std::ostringstream os;
+    for (int64_t i = 0; i < n; ++i) {
+        os << (i == 0 || rng() % 3 != 0 ? "on" : "off");
+        for (const char *axis : {" x=", ",y=", ",z="}) {
+            int lo, hi;
+            if (i < 20) {
+                lo = uniform(-50, 40);
+                hi = uniform(lo, 50);
+            } else {
+                int center = uniform(-90000, 90000), half = uniform(5000, 30000);
+                lo = center - half;
+                hi = center + half;
+            }
+            os << axis << lo << ".." << hi;
+        }
+        os << "\n";
     }
+    return os.str();
 }
+
+const Utils::Registration registration{"Day22A", "day22", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "39", solve1);
+    day.test("part1", "in2", "590784", solve1);
+    day.test("part1", "in3", "609563", solve1);
+
+    day.test("part2", "in4", "2758514936282235", solve2);
+    // Recorded from this solver's own output, then confirmed by a separate signed-cuboid
+    // inclusion-exclusion count.
+    day.test("part2", "in3", "1234650223944734", solve2);
+
+    day.bench("part1", "in3", "609563", solve1);
+    day.bench("part2", "in3", "1234650223944734", solve2);
+
+    day.generate("cuboids", generate);
+    day.scaling("part2", {25, 50, 100, 200, 400, 800}, solve2);
+}};
 } // namespace Day22A
\ No newline at end of file
@@ -1,3 +0,0 @@
-namespace Day22A {
-void main();
-}
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <cassert>
 
 namespace Day22B {
@@ -8,28 +8,24 @@ struct InputCuboid {
     int xmin, xmax, ymin, ymax, zmin, zmax;
 };
 
-std::optional<InputCuboid> read_one(std::istringstream &is) {
-    InputCuboid rv{};
-    std::string onoff, coordbuf;
-    is >> onoff >> coordbuf;
-    if (!is) {
+std::optional<InputCuboid> read_one(Utils::Tokenizer &tokenizer) {
+    auto onoff = tokenizer.next_word();
+    if (!onoff.has_value()) {
         return std::nullopt;
     }
-    rv.on = onoff == "on";
-
-    for (char &c : coordbuf) {
-        if (c != '-' && (c < '0' || c > '9')) {
-            c = ' ';
-        }
+    InputCuboid rv{};
+    rv.on = *onoff == "on";
+    for (int *coord : {&rv.xmin, &rv.xmax, &rv.ymin, &rv.ymax, &rv.zmin, &rv.zmax}) {
+        *coord = static_cast<int>(tokenizer.expect_int());
     }
-    std::istringstream{coordbuf} >> rv.xmin >> rv.xmax >> rv.ymin >> rv.ymax >> rv.zmin >> rv.zmax;
     return rv;
 }
 
-std::vector<InputCuboid> read(std::istringstream &is) {
+std::vector<InputCuboid> read(const Utils::InputView &input) {
+    auto tokenizer = input.tokenizer();
     std::vector<InputCuboid> rv;
     while (true) {
-        auto value = read_one(is);
+        auto value = read_one(tokenizer);
         if (!value.has_value()) {
             break;
         }
@@ -136,20 +132,14 @@ auto solve = [](auto &is, auto &os, int min, int max) {
     os << octree->count_on(0, min, max);
 };
 
-auto solve1 = [](auto &is, auto &os) { solve(is, os, -50, 51); };
-auto solve2 = [](auto &is, auto &os) { solve(is, os, MIN_COORD, MAX_COORD); };
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) { solve(is, os, -50, 51); };
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) { solve(is, os, MIN_COORD, MAX_COORD); };
 
-void main() {
-    {
-        Utils::Tester tester{"day22"};
-
-        tester.test("part1", "in1", "39", solve1);
-        tester.test("part1", "in2", "590784", solve1);
-        tester.test("part1", "in3", "609563", solve1);
-
-        tester.test("part2", "in4", "2758514936282235", solve2);
-        tester.test("part2", "in3", "", solve2);
-    }
-}
+// Not registered. The corner deltas only ever add coverage, so "off" steps are lost
+// (part1:in1 counts 65 rather than 39) and the octree grows until it runs out of
+// memory; count_on's assertion also fires on inner nodes whose partial sums dip below
+// zero. Day22A is the working solver. The cases this one was checked against:
+//   part1: in1 -> 39, in2 -> 590784, in3 -> 609563
+//   part2: in4 -> 2758514936282235, in3 -> (no answer recorded)
 
 } // namespace Day22B
\ No newline at end of file
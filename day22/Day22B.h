@@ -1,3 +0,0 @@
-namespace Day22B {
-void main();
-}
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <array>
 #include <cassert>
 #include <map>
@@ -206,13 +206,13 @@ struct State {
         return rv;
     }
 
-    static State read(std::istringstream &is) {
-        std::string buf;
-        std::getline(is, buf);
-        std::getline(is, buf);
-        std::array<std::string, 2> lines;
-        std::getline(is, lines[0]);
-        std::getline(is, lines[1]);
+    static State read(const Utils::InputView &input) {
+        auto tokenizer = input.tokenizer();
+        tokenizer.next_line();
+        tokenizer.next_line();
+        std::array<std::string_view, 2> lines;
+        lines[0] = tokenizer.next_line().value_or("");
+        lines[1] = tokenizer.next_line().value_or("");
 
         std::map<char, std::vector<int>> pods;
         const std::array<std::tuple<int, int, int>, M> cases{{
@@ -249,7 +249,7 @@ struct State {
 template <typename T>
 using MaxHeap = std::priority_queue<T, std::vector<T>, std::greater<T>>;
 
-auto solve1 = [](auto &is, auto &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
     State initial{State::read(is)};
 
     //int best_dist = std::numeric_limits<int>::max();
@@ -257,7 +257,6 @@ auto solve1 = [](auto &is, auto &os) {
     auto go = [&best_dist](auto go, const State &state, int dist) {
         if (state.is_final() && dist < best_dist) {
             best_dist = dist;
-            std::cout << "best dist so far: " << best_dist << "\n";
             return;
         }
         if (dist + state.estimate() >= best_dist) {
@@ -272,13 +271,11 @@ auto solve1 = [](auto &is, auto &os) {
     os << best_dist;
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day23"};
+const Utils::Registration registration{"Day23A", "day23", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "12521", solve1);
+    day.test("part1", "in2", "15160", solve1);
 
-        tester.test("part1", "in1", "12521", solve1);
-        tester.test("part1", "in2", "15160", solve1);
-    }
-}
+    day.bench("part1", "in2", "15160", solve1);
+}};
 
 } // namespace Day23A
@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <array>
 #include <cassert>
 #include <map>
@@ -206,9 +206,10 @@ struct State {
         for (int i = 0; i < M; ++i) {
             if (!is_final_pos(i)) {
                 int best_dist = std::numeric_limits<int>::max();
+                const int target = targets[i / 4]--;
                 for (int j = 0; j < N; ++j) {
                     if (!is_room[j]) {
-                        int this_dist = calcd_dist[positions[i]][j] + calcd_dist[j][targets[i / 4]--];
+                        int this_dist = calcd_dist[positions[i]][j] + calcd_dist[j][target];
                         this_dist *= cost_per_step[i];
                         best_dist = std::min(best_dist, this_dist);
                     }
@@ -219,18 +220,18 @@ struct State {
         return rv;
     }
 
-    static State read(std::istringstream &is) {
-        std::string buf;
-        std::getline(is, buf);
-        std::getline(is, buf);
-        std::array<std::string, 4> lines{
+    static State read(const Utils::InputView &input) {
+        auto tokenizer = input.tokenizer();
+        tokenizer.next_line();
+        tokenizer.next_line();
+        std::array<std::string_view, 4> lines{
             "",
             "  #D#C#B#A#",
             "  #D#B#A#C#",
             "",
         };
-        std::getline(is, lines[0]);
-        std::getline(is, lines[3]);
+        lines[0] = tokenizer.next_line().value_or("");
+        lines[3] = tokenizer.next_line().value_or("");
 
         std::map<char, std::vector<char>> pods;
         const std::array<std::tuple<int, int, char>, M> cases{{
@@ -286,29 +287,14 @@ struct State {
 template <typename T>
 using MaxHeap = std::priority_queue<T, std::vector<T>, std::greater<T>>;
 
-auto solve2 = [](auto &is, auto &os) {
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
     State initial{State::read(is)};
 
     //int best_dist = std::numeric_limits<int>::max();
     int best_dist = 100000;
-    int best_finalcount = 0;
-    int64_t states_visited = 0;
-    auto go = [&best_dist, &best_finalcount, &states_visited](auto go, const State &state, int dist) {
-        ++states_visited;
-
-        int finalcount = 0;
-        for (int i = 0; i < M; ++i) {
-            if (state.is_final_pos(i)) {
-                ++finalcount;
-            }
-        }
-        if (finalcount > best_finalcount) {
-            best_finalcount = finalcount;
-            std::cout << "best finalcount so far: " << best_finalcount << "\n";
-        }
+    auto go = [&best_dist](auto go, const State &state, int dist) {
         if (state.is_final() && dist < best_dist) {
             best_dist = dist;
-            std::cout << "best dist so far: " << best_dist << "\n";
             return;
         }
         if (dist + state.estimate() >= best_dist) {
@@ -320,20 +306,14 @@ auto solve2 = [](auto &is, auto &os) {
     };
     go(go, initial, 0);
 
-    std::cout << "total states visited: " << states_visited << "\n";
-
     os << best_dist;
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day23"};
-
-        tester.test("part2", "in1", "44169", solve2);
-        tester.test("part2", "in2", "46772", solve2);
-    }
+const Utils::Registration registration{"Day23B", "day23", [](Utils::DayEntry &day) {
+    day.test("part2", "in1", "44169", solve2);
+    day.test("part2", "in2", "46772", solve2);
 
-    Utils::bench("day23", "part2", "in2", "46772", 1, solve2);
-}
+    day.bench("part2", "in2", "46772", solve2);
+}};
 
 } // namespace Day23A
@@ -1,3 +0,0 @@
-namespace Day23B {
-void main();
-}
@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <array>
 #include <map>
 
@@ -6,22 +6,53 @@ namespace Day24A {
 
 const int N = 14;
 
-const std::array<std::tuple<int, int, int>, N> params{{
-    {1, 13, 8},
-    {1, 12, 16},
-    {1, 10, 4},
-    {26, -11, 1},
-    {1, 14, 13},
-    {1, 13, 5},
-    {1, 12, 0},
-    {26, -5, 10},
-    {1, 10, 7},
-    {26, 0, 2},
-    {26, -11, 13},
-    {26, -13, 15},
-    {26, -13, 14},
-    {26, -11, 9},
-}};
+// Per input digit, the three constants that differ between the program's 14 blocks:
+// the z divisor, the x offset and the y offset.
+using Params = std::array<std::tuple<int, int, int>, N>;
+
+Params read_params(const Utils::InputView &input) {
+    auto tokenizer = input.tokenizer();
+    Params rv{};
+    int block = -1;
+    while (auto line = tokenizer.next_line()) {
+        Utils::Tokenizer words{*line};
+        auto op = words.next_word();
+        if (!op.has_value() || op->starts_with('#')) {
+            continue;
+        }
+        if (*op == "inp") {
+            if (++block >= N) {
+                std::cerr << "ERROR: More than " << N << " inp instructions\n";
+                abort();
+            }
+            continue;
+        }
+        auto reg = words.next_word();
+        auto arg = words.next_word();
+        if (block < 0 || !reg.has_value() || !arg.has_value()) {
+            continue;
+        }
+        auto value = Utils::Tokenizer{*arg}.next_int();
+        if (!value.has_value()) {
+            continue;
+        }
+        auto &[A, B, C] = rv[block];
+        if (*op == "div" && *reg == "z") {
+            A = static_cast<int>(*value);
+        } else if (*op == "add" && *reg == "x") {
+            B = static_cast<int>(*value);
+        } else if (*op == "add" && *reg == "y") {
+            // the last constant added to y in a block is the offset
+            C = static_cast<int>(*value);
+        }
+    }
+    if (block != N - 1) {
+        std::cerr << "ERROR: Expected " << N << " inp instructions, got " << block + 1 << "\n";
+        abort();
+    }
+    return rv;
+}
+
 const std::array<int64_t, N + 2> pow10{
     []() {
         std::array<int64_t, N + 2> rv{1};
@@ -31,7 +62,7 @@ const std::array<int64_t, N + 2> pow10{
         return rv;
     }()};
 
-std::tuple<bool, int64_t> eval(int64_t input) {
+std::tuple<bool, int64_t> eval(const Params &params, int64_t input) {
     bool x = false;
     int64_t z = 0;
     for (int i = 0; i < N; ++i) {
@@ -44,7 +75,7 @@ std::tuple<bool, int64_t> eval(int64_t input) {
     return {x, z};
 }
 
-void go_left(int i, int limit, int64_t prev_input, int64_t prev_z, auto fn) {
+void go_left(const Params &params, int i, int limit, int64_t prev_input, int64_t prev_z, auto fn) {
     if (i == limit) {
         // fn(input[limit - 1], z[limit - 1])
         fn(prev_input, prev_z);
@@ -58,7 +89,7 @@ void go_left(int i, int limit, int64_t prev_input, int64_t prev_z, auto fn) {
         int64_t input = prev_input * 10 + digit;
         int x = (prev_z % 26 + B) != digit;
         int64_t z = prev_z / A * (25 * x + 1) + x * (digit + C);
-        go_left(i + 1, limit, input, z, fn);
+        go_left(params, i + 1, limit, input, z, fn);
     }
 }
 
@@ -67,10 +98,10 @@ std::tuple<int64_t, int64_t> calc_zbounds(int x, int64_t z, int inp, int C, int
     return {alpha * A, alpha * A + A - 1};
 };
 
-void go_right(int i, int limit, int64_t prev_input, int prev_digit, int prev_x, int64_t prev_z, auto fn) {
+void go_right(const Params &params, int i, int limit, int64_t prev_input, int prev_digit, int prev_x, int64_t prev_z, auto fn) {
     if (i == 13) {
         for (int digit = 1; digit <= 9; ++digit) {
-            go_right(i - 1, limit, digit, digit, 0, 0, fn);
+            go_right(params, i - 1, limit, digit, digit, 0, 0, fn);
         }
         return;
     }
@@ -89,69 +120,68 @@ void go_right(int i, int limit, int64_t prev_input, int prev_digit, int prev_x,
         for (int x = 0; x <= 1; ++x) {
             for (int digit = 1; digit <= 9; ++digit) {
                 int64_t input = prev_input + digit * pow10[N - 1 - i];
-                go_right(i - 1, limit, input, digit, x, z, fn);
+                go_right(params, i - 1, limit, input, digit, x, z, fn);
             }
         }
     }
 }
 
 const int MAX_INTERM_Z = 100000000;
-std::array<int64_t, MAX_INTERM_Z> interm_state;
 
-auto solve = [](auto &is, auto &os, int64_t init_best_answer, auto is_better_than) {
-    std::fill(interm_state.begin(), interm_state.end(), -1);
+auto solve = [](const Utils::InputView &is, std::ostringstream &os, int64_t init_best_answer, auto is_better_than) {
+    const Params params = read_params(is);
+    std::vector<int64_t> interm_state(MAX_INTERM_Z, -1);
 
-    go_left(0,
-            //11,
-            10,
-            0, 0, [&is_better_than](int64_t input, int64_t z) {
-                if (z >= MAX_INTERM_Z) {
+    {
+        UTILS_TRACE_SCOPE("go_left");
+        go_left(params, 0,
+                //11,
+                10,
+                0, 0, [&interm_state, &is_better_than](int64_t input, int64_t z) {
+                    if (z >= MAX_INTERM_Z) {
+                        return;
+                    }
+                    if (interm_state[z] == -1 || is_better_than(input, interm_state[z])) {
+                        interm_state[z] = input;
+                    }
+                });
+    }
+
+    int64_t best_answer = init_best_answer;
+    {
+        UTILS_TRACE_SCOPE("go_right");
+        go_right(params, 13, 8, 0, 0, 0, 0, [&params, &interm_state, &best_answer, &is_better_than](int64_t input, int x, int64_t z) {
+            if (interm_state[z] != -1) {
+                int64_t combined = interm_state[z] * pow10[4] + input % pow10[4];
+                auto [check_x, check_z] = eval(params, combined);
+                if (check_z != 0) {
                     return;
                 }
-                if (interm_state[z] == -1 || is_better_than(input, interm_state[z])) {
-                    interm_state[z] = input;
+                if (is_better_than(combined, best_answer)) {
+                    best_answer = combined;
+                    //std::cout << "best answer so far: " << best_answer << "\n";
                 }
-            });
-
-    int64_t best_answer = init_best_answer;
-    go_right(13, 8, 0, 0, 0, 0, [&best_answer, &is_better_than](int64_t input, int x, int64_t z) {
-        if (interm_state[z] != -1) {
-            int64_t combined = interm_state[z] * pow10[4] + input % pow10[4];
-            auto [check_x, check_z] = eval(combined);
-            if (check_z != 0) {
-                std::cout << "failed final check: combined=" << combined << " z=" << check_z << "\n";
-                std::cout << "                    stt[z]=" << interm_state[z] << " right_inp=" << input << "\n";
-                return;
-            }
-            if (is_better_than(combined, best_answer)) {
-                best_answer = combined;
-                //std::cout << "best answer so far: " << best_answer << "\n";
             }
-        }
-    });
+        });
+    }
 
     os << best_answer;
 };
 
-auto solve1 = [](auto &is, auto &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
     return solve(is, os, std::numeric_limits<int64_t>::min(), std::greater<int64_t>());
 };
 
-auto solve2 = [](auto &is, auto &os) {
+auto solve2 = [](const Utils::InputView &is, std::ostringstream &os) {
     return solve(is, os, std::numeric_limits<int64_t>::max(), std::less<int64_t>());
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day24"};
+const Utils::Registration registration{"Day24A", "day24", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "96929994293996", solve1);
+    day.test("part2", "in1", "41811761181141", solve2);
 
-        //tester.test("part1", "in1", "96929994293996", solve1);
-        //tester.test("part2", "in1", "41811761181141", solve2);
-        
-    }
-
-	Utils::bench("day24", "part1", "in1", "96929994293996", 1, solve1);
-	Utils::bench("day24", "part2", "in1", "41811761181141", 1, solve2);
-}
+    day.bench("part1", "in1", "96929994293996", solve1);
+    day.bench("part2", "in1", "41811761181141", solve2);
+}};
 
 } // namespace Day24A
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "Utils.h"
+#include "Registry.h"
 #include <array>
 
 namespace Day25A {
@@ -11,12 +11,12 @@ struct Seafloor {
 
     auto operator<=>(const Seafloor &) const = default;
 
-    void read(std::istringstream &is) {
+    void read(const Utils::InputView &input) {
         data.clear();
-        std::string line;
-        for (R = 0; is >> line; ++R) {
-            C = static_cast<int>(std::ssize(line));
-            std::copy(line.begin(), line.end(), std::back_inserter(data));
+        auto tokenizer = input.tokenizer();
+        for (R = 0; auto line = tokenizer.next_word(); ++R) {
+            C = static_cast<int>(std::ssize(*line));
+            std::copy(line->begin(), line->end(), std::back_inserter(data));
         }
     }
 
@@ -31,7 +31,7 @@ struct Seafloor {
     }
 
     bool move_one_dir(char ch, int dr, int dc) {
-        static Seafloor old;
+        static thread_local Seafloor old;
         old = *this;
         for (int r = 0; r < R; ++r) {
             for (int c = 0; c < C; ++c) {
@@ -71,9 +71,8 @@ struct Seafloor {
     }
 };
 
-Seafloor seafloor;
-
-auto solve1 = [](auto &is, auto &os) {
+auto solve1 = [](const Utils::InputView &is, std::ostringstream &os) {
+    Seafloor seafloor;
     seafloor.read(is);
     //std::cout << "Initial state:\n";
     //std::cout << seafloor.to_string();
@@ -90,13 +89,36 @@ auto solve1 = [](auto &is, auto &os) {
     }
 };
 
-void main() {
-    {
-        Utils::Tester tester{"day25"};
-
-        tester.test("part1", "in1", "58", solve1);
-        tester.test("part1", "in2", "520", solve1);
+// n x n random herd. Row 0 is all '>' and column 0 all 'v': neither can ever move, and
+// together they stop every other cucumber from wrapping around. So each move is
+// progress towards one of the walls and the herd must jam.
+std::string generate(int64_t n, std::mt19937_64 &rng) {
+    std::string rv;
+    rv.reserve((n + 1) * n);
+    for (int64_t r = 0; r < n; ++r) {
+        for (int64_t c = 0; c < n; ++c) {
+            if (c == 0) {
+                rv.push_back('v');
+            } else if (r == 0) {
+                rv.push_back('>');
+            } else {
+                int x = static_cast<int>(rng() % 20);
+                rv.push_back(x < 7 ? '>' : x < 14 ? 'v' : '.');
+            }
+        }
+        rv.push_back('\n');
     }
+    return rv;
 }
 
+const Utils::Registration registration{"Day25A", "day25", [](Utils::DayEntry &day) {
+    day.test("part1", "in1", "58", solve1);
+    day.test("part1", "in2", "520", solve1);
+
+    day.bench("part1", "in2", "520", solve1);
+
+    day.generate("grid side", generate);
+    day.scaling("part1", {50, 100, 200, 400, 800, 1600, 10000}, solve1);
+}};
+
 } // namespace Day25A
\ No newline at end of file